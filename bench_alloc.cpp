@@ -0,0 +1,46 @@
+/*
+* 统计解析与复制时的堆分配次数
+* 通过替换全局 operator new 计数；在引入 _small_vector 之前的版本上运行同一程序即可得到对比数据
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "sjson/sjson.hpp"
+#include "tests/alloc_counter.hpp"
+
+using namespace sjson;
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 10000;
+    std::string doc = "[";
+    for (int i = 0; i < count; ++i)
+    {
+        if (i)
+            doc += ",";
+        doc += "{\"id\":" + std::to_string(i) +
+               ",\"name\":\"item\",\"tags\":[\"a\",\"b\"],\"pos\":[1.5,2.5,3.5],\"ok\":true}";
+    }
+    doc += "]";
+
+    size_t before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    json j = json::parse(doc);
+    auto stop = std::chrono::steady_clock::now();
+    size_t parse_allocations = allocations - before;
+
+    before = allocations;
+    json copy = j;
+    size_t copy_allocations = allocations - before;
+
+    printf("elements:          %d\n", count);
+    printf("parse allocations: %zu (%.2f per element)\n",
+           parse_allocations, double(parse_allocations) / count);
+    printf("copy allocations:  %zu (%.2f per element)\n",
+           copy_allocations, double(copy_allocations) / count);
+    printf("parse time:        %.3f ms\n",
+           std::chrono::duration<double, std::milli>(stop - start).count());
+    printf("sizeof(json):      %zu\n", sizeof(json));
+    return 0;
+}
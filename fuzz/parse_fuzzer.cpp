@@ -0,0 +1,34 @@
+/*
+* parse 的 fuzz 目标
+* 1. 任意输入都不应崩溃或抛出异常
+* 2. 编译期校验器与解析器对输入是否合法的判断一致
+* 3. 复用 document 解析的结果与重新解析的结果相同
+*/
+#include "sjson/sjson.hpp"
+#include <cstdlib>
+
+using namespace sjson;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    const char *first = reinterpret_cast<const char *>(data);
+    const char *last = first + size;
+
+    json::error_code ec;
+    json fresh = json::parse(first, last, ec);
+    bool ok = !ec;
+
+    // 编译期校验器不检查数值范围，应当与忽略 range_error 的解析结果一致
+    json::error_code ec2;
+    json::parse(first, last, ec2, [](int kind)
+    { return kind == json::parser::range_error; });
+    if (_literal_checker{first, size}.valid() == bool(ec2))
+        abort();
+
+    // 复用上一个输入留下的树
+    static json::document doc;
+    doc.parse(first, last, ec2);
+    if (bool(ec2) != !ok || (ok && doc.root() != fresh))
+        abort();
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*
+* dump -> parse 的 fuzz 目标
+* 合法的输入在各种输出选项下序列化后再解析，结果都应与原值相同
+*/
+#include "sjson/sjson.hpp"
+#include <cstdlib>
+
+using namespace sjson;
+
+static void check(const json &x, const json::dump_options &opt)
+{
+    std::string s = x.dump(opt);
+    json::error_code ec;
+    json y = json::parse(s, ec);
+    if (ec || y != x)
+        abort();
+    // 输出应当是稳定的
+    if (opt.canonical && y.dump(opt) != s)
+        abort();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    const char *first = reinterpret_cast<const char *>(data);
+    json::error_code ec;
+    json x = json::parse(first, first + size, ec);
+    if (ec)
+        return 0;
+
+    json::dump_options opt;
+    check(x, opt);
+    opt.indent.clear();
+    check(x, opt);
+    opt.sort_keys = true;
+    opt.space_after_comma = true;
+    check(x, opt);
+    json::dump_options canonical;
+    canonical.canonical = true;
+    check(x, canonical);
+
+    // 非法的 UTF-8 会被替换为 U+FFFD ，因此只检查再次输出的结果不变
+    json::dump_options ascii;
+    ascii.ascii_only = true;
+    ascii.sort_keys = true;
+    std::string s = x.dump(ascii);
+    json y = json::parse(s, ec);
+    if (ec || y.dump(ascii) != s)
+        abort();
+    for (unsigned char c : s)
+        if (c >= 0x80)
+            abort();
+
+    if (x.hash() != json::parse(x.dump()).hash())
+        abort();
+    return 0;
+}
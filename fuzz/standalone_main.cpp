@@ -0,0 +1,37 @@
+// 不使用 libFuzzer 时的驱动：依次将每个文件（或标准输入）交给 fuzz 目标
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static void run(const std::string &input)
+{
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(input.data()), input.size());
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::string input((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+        run(input);
+        return 0;
+    }
+    for (int i = 1; i < argc; ++i)
+    {
+        std::ifstream in(argv[i], std::ios::binary);
+        if (!in)
+        {
+            fprintf(stderr, "cannot open %s\n", argv[i]);
+            return 1;
+        }
+        run(std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>()));
+    }
+    printf("%d inputs\n", argc - 1);
+    return 0;
+}
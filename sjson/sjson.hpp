@@ -10,8 +10,32 @@
 #include <functional>
 #include <type_traits>
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cfloat>
+#include <climits>
+#include <cstdint>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <iterator>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+
 #define _SJSON_DISABLE_AUTO_TYPE_ADJUST
 
+// 解析时允许的最大嵌套深度，超出时报告 syntax_error
+#ifndef _SJSON_MAX_DEPTH
+#define _SJSON_MAX_DEPTH 1024
+#endif
+
 #if defined(_MSC_VER)
 #define _HASCPP14 (_MSVC_LANG >= 201402L)
 #else
@@ -36,26 +60,50 @@ public:
 private:
     void *_data;
 };
+/*
+* 不超过 _inline_size 且可以无异常移动的类型直接存放在内部缓冲区中，
+* 否则在堆上分配
+*/
+template <size_t _inline_size>
 class _fake_union
 {
 public:
-    _fake_union() : _data(nullptr) {}
+    _fake_union() : _data(nullptr), _ops(nullptr) {}
     _fake_union(const _fake_union &x)
     {
         _data = nullptr;
         _assign(x);
     }
-    template <typename _t>
-    _fake_union(const _t &x)
+    _fake_union(_fake_union &&x) noexcept
+    {
+        _data = nullptr;
+        _move_from(x);
+    }
+    template <
+        typename _t,
+        typename std::enable_if<
+            !std::is_same<typename std::decay<_t>::type, _fake_union>::value, int
+        >::type = 0
+    > _fake_union(const _t &x)
     {
         _data = nullptr;
         set(x);
     }
     const _fake_union &operator=(const _fake_union &x)
     {
-        _assign(x);
+        if (this != &x)
+            _assign(x);
         return x;
     }
+    _fake_union &operator=(_fake_union &&x) noexcept
+    {
+        if (this != &x)
+        {
+            _destroy_data();
+            _move_from(x);
+        }
+        return *this;
+    }
 
     ~_fake_union()
     {
@@ -72,6 +120,12 @@ public:
         _data = nullptr;
     }
 
+    template <typename _t>
+    inline bool holds() const
+    {
+        return _data != nullptr && _ops == _ops_of<_t>::get();
+    }
+
     template <typename _t>
     inline _t &get()
     {
@@ -105,597 +159,2877 @@ public:
     void set(const _t &x)
     {
         _destroy_data();
-        _destructor = [](void *p)
-        { delete (_t *)p; };
-        _copy_constructor = [](void *x)
-        { return new _t(*((_t *)x)); };
-        _data = new _t(x);
+        _data = nullptr;
+        _construct<_t>(x);
+    }
+    template <
+        typename _t,
+        typename std::enable_if<
+            !std::is_lvalue_reference<_t>::value, int
+        >::type = 0
+    > void set(_t &&x)
+    {
+        _destroy_data();
+        _data = nullptr;
+        _construct<_t>(std::move(x));
     }
 
 private:
-    void *_data = nullptr;
-    std::function<void(void *)> _destructor;
-    std::function<void *(void *)> _copy_constructor;
+    struct _ops_t
+    {
+        void (*destroy)(_fake_union &);
+        void (*copy)(_fake_union &, const _fake_union &);
+        void (*move)(_fake_union &, _fake_union &);
+    };
+    template <typename _t>
+    struct _is_inline
+    {
+        static constexpr bool value =
+            sizeof(_t) <= _inline_size &&
+            alignof(_t) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible<_t>::value;
+    };
+    // 每种类型对应一张静态的操作表，代替逐个对象保存的 std::function
+    template <typename _t, bool _inline = _is_inline<_t>::value>
+    struct _ops_of
+    {
+        template <typename _arg_t>
+        static void construct(_fake_union &dest, _arg_t &&x)
+        {
+            dest._data = new (&dest._buf) _t(std::forward<_arg_t>(x));
+        }
+        static void destroy(_fake_union &x) { x.get<_t>().~_t(); }
+        static void copy(_fake_union &dest, const _fake_union &src)
+        {
+            dest._data = new (&dest._buf) _t(src.get<_t>());
+        }
+        static void move(_fake_union &dest, _fake_union &src)
+        {
+            dest._data = new (&dest._buf) _t(std::move(src.get<_t>()));
+            destroy(src);
+        }
+        static const _ops_t *get()
+        {
+            static const _ops_t ops = {destroy, copy, move};
+            return &ops;
+        }
+    };
+    template <typename _t>
+    struct _ops_of<_t, false>
+    {
+        template <typename _arg_t>
+        static void construct(_fake_union &dest, _arg_t &&x)
+        {
+            dest._data = new _t(std::forward<_arg_t>(x));
+        }
+        static void destroy(_fake_union &x) { delete &x.get<_t>(); }
+        static void copy(_fake_union &dest, const _fake_union &src)
+        {
+            dest._data = new _t(src.get<_t>());
+        }
+        static void move(_fake_union &dest, _fake_union &src)
+        {
+            dest._data = src._data;
+        }
+        static const _ops_t *get()
+        {
+            static const _ops_t ops = {destroy, copy, move};
+            return &ops;
+        }
+    };
+
+    void *_data;
+    const _ops_t *_ops;
+    typename std::aligned_storage<_inline_size, alignof(std::max_align_t)>::type _buf;
+
+    template <typename _t, typename _arg_t>
+    void _construct(_arg_t &&x)
+    {
+        _ops_of<_t>::construct(*this, std::forward<_arg_t>(x));
+        _ops = _ops_of<_t>::get();
+    }
 
     void _destroy_data()
     {
         if (!empty())
-            _destructor(_data);
+            _ops->destroy(*this);
         // 可以不设为空指针，因为该函数在内部使用，可确保调用后会赋值
     }
 
     void _assign(const _fake_union &x)
     {
         _destroy_data();
-        _destructor = x._destructor;
-        _copy_constructor = x._copy_constructor;
+        _ops = x._ops;
+        _data = nullptr;
         if (x._data != nullptr)
-            _data = _copy_constructor(x._data);
-        else
-            _data = nullptr;
+            _ops->copy(*this, x);
+    }
+    // 调用前 *this 必须已经为空
+    void _move_from(_fake_union &x) noexcept
+    {
+        _ops = x._ops;
+        _data = nullptr;
+        if (x._data != nullptr)
+            _ops->move(*this, x);
+        x._data = nullptr;
     }
 };
 
-class u8string
-{
-
-};
-
-enum class json_type
-{
-    value,
-    array,
-    object
-};
-constexpr inline const char *json_type_name(json_type x)
-{
-    /* 为了兼容 c++11 。。。 */
-    return x == json_type::array
-                ? "array"
-                : (x == json_type::object ? "object" : "value");
-}
-
-class json_error
-{
-public:
-    json_error(){}
-    json_error(const char *str) : _msg(str) {}
-    json_error(const std::string &str) : _msg(str) {}
-    json_error(int line, const char *func, const std::string &str)
-        : _msg(std::string("sjson.hpp:") + std::to_string(line) +
-               ':' + func + ":\n  " + str) {}
-    const char *what() const { return _msg.c_str(); }
-
-private:
-    std::string _msg;
-};
-
-#define _SJSON_TRY(expr)                                 \
-    do                                                   \
-    {                                                    \
-        try                                              \
-        {                                                \
-            expr;                                        \
-        }                                                \
-        catch (const json_error &e)                      \
-        {                                                \
-            throw json_error(                            \
-                __LINE__, __FUNCTION__,                  \
-                std::string(#expr) + " -> " + e.what()   \
-            );                                           \
-        }                                                \
-    } while (0)
-
-#define _SJSON_THROW(str) throw json_error(__LINE__,__FUNCTION__,str)
 /*
-* 禁用意外类型的自动类型调整
-* 如：对 array 对象使用 ["key"]
-*   如果是 const array 则会返回空的 json
-*   如果是 array 则会将该结点转换成 object 再返回
+* 类似 std::vector（没有 allocator 相关的成员），
+* 但前 _n 个元素存放在对象内部的缓冲区中，超出后才在堆上分配
 */
-#ifndef _SJSON_DISABLE_AUTO_TYPE_ADJUST
-#define _SJSON_THROW_TYPE_ADJUST(dest, need) ((void)0)
-#define _SJSON_THROW_TYPE_ADJUST_(dest, need) ((void)0)
-#else
-#define _SJSON_THROW_TYPE_ADJUST_RAW(dest, need) \
-_SJSON_THROW(std::string("call method of json::") + need + " on json::" + dest)
-#define _SJSON_THROW_TYPE_ADJUST(dest, need) \
-_SJSON_THROW_TYPE_ADJUST_RAW(json_type_name(dest), json_type_name(need))
-#endif
-
-template<typename T>
-class json_base
+template <typename _t, size_t _n>
+class _small_vector
 {
-private:
-    class _my_initializer_list;
+    template <typename _iter_t>
+    using _if_iterator = typename std::enable_if<!std::is_integral<_iter_t>::value>::type;
+
 public:
-    using string_t = std::string;
-    using string_char_t = typename string_t::value_type;
+    using value_type = _t;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = _t &;
+    using const_reference = const _t &;
+    using pointer = _t *;
+    using const_pointer = const _t *;
+    using iterator = _t *;
+    using const_iterator = const _t *;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    _small_vector() : _begin(_inline_data()), _size(0), _cap(_n) {}
+    _small_vector(const _small_vector &x) : _small_vector()
+    {
+        reserve(x._size);
+        for (const auto &it : x)
+            new (_begin + _size++) _t(it);
+    }
+    _small_vector(_small_vector &&x) noexcept : _small_vector()
+    {
+        _steal(x);
+    }
+    explicit _small_vector(size_type n) : _small_vector()
+    {
+        resize(n);
+    }
+    _small_vector(size_type n, const _t &x) : _small_vector()
+    {
+        assign(n, x);
+    }
+    template <typename _iter_t, typename = _if_iterator<_iter_t>>
+    _small_vector(_iter_t first, _iter_t last) : _small_vector()
+    {
+        assign(first, last);
+    }
+    _small_vector(std::initializer_list<_t> x) : _small_vector()
+    {
+        assign(x.begin(), x.end());
+    }
+    ~_small_vector()
+    {
+        clear();
+        _release();
+    }
 
-    class value
+    _small_vector &operator=(const _small_vector &x)
     {
-    public:
-        enum
+        if (this != &x)
         {
-            null,
-            number_double,
-            number_integer,
-            boolean,
-            string
-        };
-
-        value() { assign(nullptr); }
-        value(std::nullptr_t) { assign(nullptr); }
-        value(bool x) { assign(x); }
-        value(double x) { assign(x); }
-        value(int x) { assign(x); }
-        value(const string_char_t *x) { assign(x); }
-        value(const string_t &x) { assign(x); }
-        value(const value &x) { assign(x); }
-
-        const value &operator=(const value &x)
+            clear();
+            reserve(x._size);
+            for (const auto &it : x)
+                new (_begin + _size++) _t(it);
+        }
+        return *this;
+    }
+    _small_vector &operator=(_small_vector &&x) noexcept
+    {
+        if (this != &x)
         {
-            assign(x);
-            return x;
+            clear();
+            _release();
+            _begin = _inline_data();
+            _cap = _n;
+            _steal(x);
         }
+        return *this;
+    }
+    _small_vector &operator=(std::initializer_list<_t> x)
+    {
+        assign(x.begin(), x.end());
+        return *this;
+    }
 
-        virtual ~value() = default;
-
-        operator double() const { return as<double>(); }
-        operator int() const { return as<int>(); }
-        operator bool() const { return as<bool>(); }
-        operator string_t() const { return as<string_t>(); }
-
-#define _MAKE(needtype, needtypeval)               \
-    template <                                     \
-        typename _t,                               \
-        typename std::enable_if<                   \
-            std::is_same<_t, needtype>::value, int \
-        >::type = 0                                \
-    > needtype &as()                               \
-    {                                              \
-        ensure_is(needtypeval);                    \
-        return _data.as<needtype>();               \
-    }                                              \
-    template <                                     \
-        typename _t,                               \
-        typename std::enable_if<                   \
-            std::is_same<_t, needtype>::value, int \
-        >::type = 0                                \
-    > const needtype &as() const                   \
-    {                                              \
-        ensure_is(needtypeval);                    \
-        return _data.as<needtype>();               \
-    }                                              \
-    void assign(needtype x)                        \
-    {                                              \
-        _type = needtypeval;                       \
-        _data = x;                                 \
+    void assign(size_type n, const _t &x)
+    {
+        // x 可能引用自身的元素
+        _t tmp(x);
+        clear();
+        reserve(n);
+        while (_size < n)
+            new (_begin + _size++) _t(tmp);
+    }
+    template <typename _iter_t, typename = _if_iterator<_iter_t>>
+    void assign(_iter_t first, _iter_t last)
+    {
+        clear();
+        for (; first != last; ++first)
+            emplace_back(*first);
+    }
+    void assign(std::initializer_list<_t> x)
+    {
+        assign(x.begin(), x.end());
     }
 
-        _MAKE(double, number_double)
-        _MAKE(int, number_integer)
-        _MAKE(bool, boolean)
-        _MAKE(string_t, string)
+    void swap(_small_vector &x) noexcept
+    {
+        _small_vector tmp(std::move(x));
+        x = std::move(*this);
+        *this = std::move(tmp);
+    }
+    friend void swap(_small_vector &a, _small_vector &b) noexcept
+    {
+        a.swap(b);
+    }
 
-    #undef _MAKE
+    inline iterator begin() { return _begin; }
+    inline iterator end() { return _begin + _size; }
+    inline const_iterator begin() const { return _begin; }
+    inline const_iterator end() const { return _begin + _size; }
+    inline const_iterator cbegin() const { return _begin; }
+    inline const_iterator cend() const { return _begin + _size; }
+    inline reverse_iterator rbegin() { return reverse_iterator(end()); }
+    inline reverse_iterator rend() { return reverse_iterator(begin()); }
+    inline const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    inline const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    inline size_type size() const { return _size; }
+    inline size_type capacity() const { return _cap; }
+    inline size_type max_size() const { return size_type(-1) / sizeof(_t); }
+    inline bool empty() const { return _size == 0; }
+    inline _t *data() { return _begin; }
+    inline const _t *data() const { return _begin; }
+
+    inline _t &operator[](size_type idx) { return _begin[idx]; }
+    inline const _t &operator[](size_type idx) const { return _begin[idx]; }
+    _t &at(size_type idx)
+    {
+        if (idx >= _size)
+            throw std::out_of_range("_small_vector::at");
+        return _begin[idx];
+    }
+    const _t &at(size_type idx) const
+    {
+        if (idx >= _size)
+            throw std::out_of_range("_small_vector::at");
+        return _begin[idx];
+    }
+    inline _t &front() { return _begin[0]; }
+    inline const _t &front() const { return _begin[0]; }
+    inline _t &back() { return _begin[_size - 1]; }
+    inline const _t &back() const { return _begin[_size - 1]; }
 
-        void assign()
+    void reserve(size_type cap)
+    {
+        if (cap <= _cap)
+            return;
+        _t *p = static_cast<_t *>(::operator new(cap * sizeof(_t)));
+        for (size_type i = 0; i < _size; ++i)
         {
-            _type = null;
-            _data.clear();
+            new (p + i) _t(std::move_if_noexcept(_begin[i]));
+            _begin[i].~_t();
         }
-        void assign(std::nullptr_t) { _type = null; }
-        void assign(const string_char_t *x) { assign(string_t(x)); }
-        void assign(const value &x)
+        _release();
+        _begin = p;
+        _cap = cap;
+    }
+    void resize(size_type n)
+    {
+        if (n < _size)
         {
-            _type = x._type;
-            _data = x._data;
+            while (_size > n)
+                pop_back();
+            return;
         }
-
-        void clear()
+        reserve(n);
+        while (_size < n)
+            new (_begin + _size++) _t();
+    }
+    void resize(size_type n, const _t &x)
+    {
+        if (n <= _size)
         {
-            switch (_type)
-            {
-            case number_double:
-                as<double>() = 0;
-            case number_integer:
-                as<int>() = 0;
-            case string:
-                as<string_t>().clear();
-            case boolean:
-                as<bool>() = 0;
-            }
+            resize(n);
+            return;
         }
+        _t tmp(x);
+        reserve(n);
+        while (_size < n)
+            new (_begin + _size++) _t(tmp);
+    }
+    // 元素不超过 _n 个时移回内部缓冲区
+    void shrink_to_fit()
+    {
+        if (_is_inline() || _size == _cap)
+            return;
+        _small_vector tmp(std::make_move_iterator(begin()), std::make_move_iterator(end()));
+        *this = std::move(tmp);
+    }
+    void clear()
+    {
+        while (_size > 0)
+            _begin[--_size].~_t();
+    }
+
+    void push_back(const _t &x) { emplace_back(x); }
+    void push_back(_t &&x) { emplace_back(std::move(x)); }
+    template <typename... _args_t>
+    _t &emplace_back(_args_t &&...args)
+    {
+        if (_size == _cap)
+        {
+            // 参数可能引用自身的元素，先构造再扩容
+            _t tmp(std::forward<_args_t>(args)...);
+            _grow();
+            return *new (_begin + _size++) _t(std::move(tmp));
+        }
+        return *new (_begin + _size++) _t(std::forward<_args_t>(args)...);
+    }
+    void pop_back()
+    {
+        _begin[--_size].~_t();
+    }
+
+    iterator insert(const_iterator pos, const _t &x)
+    {
+        return emplace(pos, x);
+    }
+    iterator insert(const_iterator pos, _t &&x)
+    {
+        return emplace(pos, std::move(x));
+    }
+    iterator insert(const_iterator pos, size_type n, const _t &x)
+    {
+        size_type idx = pos - _begin, old_size = _size;
+        _t tmp(x);
+        reserve(_size + n);
+        while (_size < old_size + n)
+            new (_begin + _size++) _t(tmp);
+        std::rotate(_begin + idx, _begin + old_size, end());
+        return _begin + idx;
+    }
+    // 先追加到末尾再旋转到 pos 处
+    template <typename _iter_t, typename = _if_iterator<_iter_t>>
+    iterator insert(const_iterator pos, _iter_t first, _iter_t last)
+    {
+        size_type idx = pos - _begin, old_size = _size;
+        for (; first != last; ++first)
+            emplace_back(*first);
+        std::rotate(_begin + idx, _begin + old_size, end());
+        return _begin + idx;
+    }
+    iterator insert(const_iterator pos, std::initializer_list<_t> x)
+    {
+        return insert(pos, x.begin(), x.end());
+    }
+    template <typename... _args_t>
+    iterator emplace(const_iterator pos, _args_t &&...args)
+    {
+        size_type idx = pos - _begin;
+        _t tmp(std::forward<_args_t>(args)...);
+        if (_size == _cap)
+            _grow();
+        if (idx == _size)
+        {
+            new (_begin + _size++) _t(std::move(tmp));
+            return _begin + idx;
+        }
+        new (_begin + _size) _t(std::move(_begin[_size - 1]));
+        for (size_type i = _size - 1; i > idx; --i)
+            _begin[i] = std::move(_begin[i - 1]);
+        _begin[idx] = std::move(tmp);
+        ++_size;
+        return _begin + idx;
+    }
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        iterator dest = _begin + (first - _begin);
+        iterator src = _begin + (last - _begin);
+        if (first == last)
+            return dest;
+        iterator e = end();
+        iterator res = dest;
+        for (; src != e; ++src, ++dest)
+            *dest = std::move(*src);
+        while (end() != dest)
+            pop_back();
+        return res;
+    }
+
+    friend bool operator==(const _small_vector &a, const _small_vector &b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+    }
+    friend bool operator!=(const _small_vector &a, const _small_vector &b)
+    {
+        return !(a == b);
+    }
+    friend bool operator<(const _small_vector &a, const _small_vector &b)
+    {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+    }
+    friend bool operator>(const _small_vector &a, const _small_vector &b)
+    {
+        return b < a;
+    }
+    friend bool operator<=(const _small_vector &a, const _small_vector &b)
+    {
+        return !(b < a);
+    }
+    friend bool operator>=(const _small_vector &a, const _small_vector &b)
+    {
+        return !(a < b);
+    }
+
+private:
+    _t *_begin;
+    size_type _size, _cap;
+    typename std::aligned_storage<sizeof(_t) * _n, alignof(_t)>::type _buf;
+
+    inline _t *_inline_data() { return reinterpret_cast<_t *>(&_buf); }
+    inline bool _is_inline() const
+    {
+        return _begin == reinterpret_cast<const _t *>(&_buf);
+    }
+    void _grow()
+    {
+        reserve(_cap * 2);
+    }
+    void _release()
+    {
+        if (!_is_inline())
+            ::operator delete(_begin);
+    }
+    // 调用前 *this 必须为空且使用内部缓冲区
+    void _steal(_small_vector &x)
+    {
+        if (x._is_inline())
+        {
+            for (size_type i = 0; i < x._size; ++i)
+            {
+                new (_begin + i) _t(std::move(x._begin[i]));
+                x._begin[i].~_t();
+            }
+            _size = x._size;
+            x._size = 0;
+            return;
+        }
+        _begin = x._begin;
+        _size = x._size;
+        _cap = x._cap;
+        x._begin = x._inline_data();
+        x._size = 0;
+        x._cap = _n;
+    }
+};
+
+class u8string
+{
+
+};
+
+/*
+* xxHash64 (https://github.com/Cyan4973/xxHash)
+* 按小端序读取，保证不同平台上结果相同
+*/
+static constexpr uint64_t _xxh64_prime1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t _xxh64_prime2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64_t _xxh64_prime3 = 0x165667B19E3779F9ULL;
+static constexpr uint64_t _xxh64_prime4 = 0x85EBCA77C2B2AE63ULL;
+static constexpr uint64_t _xxh64_prime5 = 0x27D4EB2F165667C5ULL;
+
+static constexpr uint64_t _hash_seed_null = 0x6e756c6cULL;
+static constexpr uint64_t _hash_seed_boolean = 0x626f6f6cULL;
+static constexpr uint64_t _hash_seed_number = 0x6e756d62ULL;
+static constexpr uint64_t _hash_seed_string = 0x73747269ULL;
+static constexpr uint64_t _hash_seed_array = 0x61727261ULL;
+static constexpr uint64_t _hash_seed_object = 0x6f626a65ULL;
+
+inline uint64_t _xxh64_rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+inline uint64_t _xxh64_read64(const unsigned char *p)
+{
+    uint64_t x = 0;
+    for (int i = 7; i >= 0; --i)
+        x = (x << 8) | p[i];
+    return x;
+}
+inline uint64_t _xxh64_read32(const unsigned char *p)
+{
+    return uint64_t(p[0]) | (uint64_t(p[1]) << 8) |
+           (uint64_t(p[2]) << 16) | (uint64_t(p[3]) << 24);
+}
+inline uint64_t _xxh64_round(uint64_t acc, uint64_t input)
+{
+    acc += input * _xxh64_prime2;
+    acc = _xxh64_rotl(acc, 31);
+    return acc * _xxh64_prime1;
+}
+inline uint64_t _xxh64_merge(uint64_t acc, uint64_t val)
+{
+    acc ^= _xxh64_round(0, val);
+    return acc * _xxh64_prime1 + _xxh64_prime4;
+}
+inline uint64_t _xxh64_avalanche(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= _xxh64_prime2;
+    h ^= h >> 29;
+    h *= _xxh64_prime3;
+    h ^= h >> 32;
+    return h;
+}
+// 相当于对单个 64 位整数计算 xxHash64
+inline uint64_t _xxh64_mix(uint64_t seed, uint64_t x)
+{
+    uint64_t h = seed + _xxh64_prime5 + 8;
+    h ^= _xxh64_round(0, x);
+    h = _xxh64_rotl(h, 27) * _xxh64_prime1 + _xxh64_prime4;
+    return _xxh64_avalanche(h);
+}
+inline uint64_t _xxh64(const void *data, size_t len, uint64_t seed)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    const unsigned char *end = p + len;
+    uint64_t h;
+    if (len >= 32)
+    {
+        uint64_t v1 = seed + _xxh64_prime1 + _xxh64_prime2;
+        uint64_t v2 = seed + _xxh64_prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - _xxh64_prime1;
+        for (; end - p >= 32; p += 32)
+        {
+            v1 = _xxh64_round(v1, _xxh64_read64(p));
+            v2 = _xxh64_round(v2, _xxh64_read64(p + 8));
+            v3 = _xxh64_round(v3, _xxh64_read64(p + 16));
+            v4 = _xxh64_round(v4, _xxh64_read64(p + 24));
+        }
+        h = _xxh64_rotl(v1, 1) + _xxh64_rotl(v2, 7) +
+            _xxh64_rotl(v3, 12) + _xxh64_rotl(v4, 18);
+        h = _xxh64_merge(h, v1);
+        h = _xxh64_merge(h, v2);
+        h = _xxh64_merge(h, v3);
+        h = _xxh64_merge(h, v4);
+    }
+    else
+        h = seed + _xxh64_prime5;
+    h += len;
+    for (; end - p >= 8; p += 8)
+    {
+        h ^= _xxh64_round(0, _xxh64_read64(p));
+        h = _xxh64_rotl(h, 27) * _xxh64_prime1 + _xxh64_prime4;
+    }
+    if (end - p >= 4)
+    {
+        h ^= _xxh64_read32(p) * _xxh64_prime1;
+        h = _xxh64_rotl(h, 23) * _xxh64_prime2 + _xxh64_prime3;
+        p += 4;
+    }
+    for (; p != end; ++p)
+    {
+        h ^= (*p) * _xxh64_prime5;
+        h = _xxh64_rotl(h, 11) * _xxh64_prime1;
+    }
+    return _xxh64_avalanche(h);
+}
+
+#if _HASCPP14
+/*
+* 编译期 json 校验，规则与 parser 相同（不检查数值是否超出范围）
+* 各函数返回处理结束的位置，出错时返回 npos
+*/
+struct _literal_checker
+{
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    const char *s;
+    size_t n;
+
+    constexpr bool valid() const
+    {
+        size_t i = node(blank(0), 0);
+        return i != npos && blank(i) == n;
+    }
+
+    constexpr size_t blank(size_t i) const
+    {
+        while (i < n && (s[i] == ' ' || s[i] == '\t' || s[i] == '\n' || s[i] == '\r'))
+            ++i;
+        return i;
+    }
+    constexpr size_t word(size_t i, const char *w) const
+    {
+        for (; *w; ++w, ++i)
+            if (i >= n || s[i] != *w)
+                return npos;
+        return i;
+    }
+    constexpr size_t digits(size_t i) const
+    {
+        if (i >= n || s[i] < '0' || s[i] > '9')
+            return npos;
+        while (i < n && s[i] >= '0' && s[i] <= '9')
+            ++i;
+        return i;
+    }
+    // 返回 4 位十六进制数的值，出错时返回 -1
+    constexpr long hex4(size_t i) const
+    {
+        long res = 0;
+        for (size_t k = i + 4; i < k; ++i)
+        {
+            if (i >= n)
+                return -1;
+            char c = s[i];
+            res <<= 4;
+            if (c >= '0' && c <= '9')
+                res |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                res |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                res |= c - 'A' + 10;
+            else
+                return -1;
+        }
+        return res;
+    }
+
+    // depth 为 i 处的值所在的嵌套深度
+    constexpr size_t node(size_t i, size_t depth) const
+    {
+        if (i >= n)
+            return npos;
+        switch (s[i])
+        {
+        case '{':
+            return depth == _SJSON_MAX_DEPTH ? npos : object(i, depth + 1);
+        case '[':
+            return depth == _SJSON_MAX_DEPTH ? npos : array(i, depth + 1);
+        case '"':
+            return string(i);
+        case 't':
+            return word(i, "true");
+        case 'f':
+            return word(i, "false");
+        case 'n':
+            return word(i, "null");
+        }
+        return number(i);
+    }
+    constexpr size_t object(size_t i, size_t depth) const
+    {
+        i = blank(i + 1);
+        if (i < n && s[i] == '}')
+            return i + 1;
+        for (;;)
+        {
+            i = blank(i);
+            if (i >= n || s[i] != '"' || (i = string(i)) == npos)
+                return npos;
+            i = blank(i);
+            if (i >= n || s[i] != ':' || (i = node(blank(i + 1), depth)) == npos)
+                return npos;
+            i = blank(i);
+            if (i >= n)
+                return npos;
+            if (s[i] == '}')
+                return i + 1;
+            if (s[i++] != ',')
+                return npos;
+        }
+    }
+    constexpr size_t array(size_t i, size_t depth) const
+    {
+        i = blank(i + 1);
+        if (i < n && s[i] == ']')
+            return i + 1;
+        for (;;)
+        {
+            if ((i = node(blank(i), depth)) == npos)
+                return npos;
+            i = blank(i);
+            if (i >= n)
+                return npos;
+            if (s[i] == ']')
+                return i + 1;
+            if (s[i++] != ',')
+                return npos;
+        }
+    }
+    constexpr size_t string(size_t i) const
+    {
+        for (++i;;)
+        {
+            if (i >= n || static_cast<unsigned char>(s[i]) < 0x20)
+                return npos;
+            char c = s[i++];
+            if (c == '"')
+                return i;
+            if (c != '\\')
+                continue;
+            if (i >= n)
+                return npos;
+            c = s[i++];
+            if (c == 'u')
+            {
+                long cp = hex4(i);
+                i += 4;
+                if (cp >= 0xDC00 && cp <= 0xDFFF)
+                    return npos;
+                if (cp >= 0xD800 && cp <= 0xDBFF)
+                {
+                    // 高代理项后必须紧跟低代理项
+                    if (i + 1 >= n || s[i] != '\\' || s[i + 1] != 'u')
+                        return npos;
+                    long lo = hex4(i + 2);
+                    if (lo < 0xDC00 || lo > 0xDFFF)
+                        return npos;
+                    i += 6;
+                }
+                else if (cp < 0)
+                    return npos;
+            }
+            else if (c != '"' && c != '\\' && c != '/' && c != 'b' &&
+                     c != 'f' && c != 'n' && c != 'r' && c != 't')
+                return npos;
+        }
+    }
+    constexpr size_t number(size_t i) const
+    {
+        if (i < n && s[i] == '-')
+            ++i;
+        if (i < n && s[i] == '0')
+            ++i;
+        else if ((i = digits(i)) == npos)
+            return npos;
+        if (i < n && s[i] == '.' && (i = digits(i + 1)) == npos)
+            return npos;
+        if (i < n && (s[i] == 'e' || s[i] == 'E'))
+        {
+            ++i;
+            if (i < n && (s[i] == '+' || s[i] == '-'))
+                ++i;
+            i = digits(i);
+        }
+        return i;
+    }
+};
+#endif
+
+enum class json_type
+{
+    value,
+    array,
+    object
+};
+constexpr inline const char *json_type_name(json_type x)
+{
+    /* 为了兼容 c++11 。。。 */
+    return x == json_type::array
+                ? "array"
+                : (x == json_type::object ? "object" : "value");
+}
+
+class json_error
+{
+public:
+    json_error(){}
+    json_error(const char *str) : _msg(str) {}
+    json_error(const std::string &str) : _msg(str) {}
+    json_error(int line, const char *func, const std::string &str)
+        : _msg(std::string("sjson.hpp:") + std::to_string(line) +
+               ':' + func + ":\n  " + str) {}
+    const char *what() const { return _msg.c_str(); }
+
+private:
+    std::string _msg;
+};
+
+#define _SJSON_TRY(expr)                                 \
+    do                                                   \
+    {                                                    \
+        try                                              \
+        {                                                \
+            expr;                                        \
+        }                                                \
+        catch (const json_error &e)                      \
+        {                                                \
+            throw json_error(                            \
+                __LINE__, __FUNCTION__,                  \
+                std::string(#expr) + " -> " + e.what()   \
+            );                                           \
+        }                                                \
+    } while (0)
+
+#define _SJSON_THROW(str) throw json_error(__LINE__,__FUNCTION__,str)
+/*
+* 禁用意外类型的自动类型调整
+* 如：对 array 对象使用 ["key"]
+*   如果是 const array 则会返回空的 json
+*   如果是 array 则会将该结点转换成 object 再返回
+*/
+#ifndef _SJSON_DISABLE_AUTO_TYPE_ADJUST
+#define _SJSON_THROW_TYPE_ADJUST(dest, need) ((void)0)
+#define _SJSON_THROW_TYPE_ADJUST_(dest, need) ((void)0)
+#else
+#define _SJSON_THROW_TYPE_ADJUST_RAW(dest, need) \
+_SJSON_THROW(std::string("call method of json::") + need + " on json::" + dest)
+#define _SJSON_THROW_TYPE_ADJUST(dest, need) \
+_SJSON_THROW_TYPE_ADJUST_RAW(json_type_name(dest), json_type_name(need))
+#endif
+
+template<typename T>
+class json_base
+{
+private:
+    class _my_initializer_list;
+public:
+    using string_t = std::string;
+    using string_char_t = typename string_t::value_type;
+
+    class value
+    {
+    public:
+        enum
+        {
+            null,
+            number_double,
+            number_integer,
+            boolean,
+            string
+        };
+
+        value() { assign(nullptr); }
+        value(std::nullptr_t) { assign(nullptr); }
+        value(bool x) { assign(x); }
+        value(double x) { assign(x); }
+        value(int x) { assign(x); }
+        value(const string_char_t *x) { assign(x); }
+        value(const string_t &x) { assign(x); }
+        value(const value &x) { assign(x); }
+        value(value &&x) noexcept
+            : _type(x._type), _data(std::move(x._data)) {}
+
+        const value &operator=(const value &x)
+        {
+            assign(x);
+            return x;
+        }
+        value &operator=(value &&x) noexcept
+        {
+            _type = x._type;
+            _data = std::move(x._data);
+            return *this;
+        }
+
+        virtual ~value() = default;
+
+        operator double() const { return as<double>(); }
+        operator int() const { return as<int>(); }
+        operator bool() const { return as<bool>(); }
+        operator string_t() const { return as<string_t>(); }
+
+#define _MAKE(needtype, needtypeval)               \
+    template <                                     \
+        typename _t,                               \
+        typename std::enable_if<                   \
+            std::is_same<_t, needtype>::value, int \
+        >::type = 0                                \
+    > needtype &as()                               \
+    {                                              \
+        ensure_is(needtypeval);                    \
+        return _data.template as<needtype>();               \
+    }                                              \
+    template <                                     \
+        typename _t,                               \
+        typename std::enable_if<                   \
+            std::is_same<_t, needtype>::value, int \
+        >::type = 0                                \
+    > const needtype &as() const                   \
+    {                                              \
+        ensure_is(needtypeval);                    \
+        return _data.template as<needtype>();               \
+    }                                              \
+    void assign(needtype x)                        \
+    {                                              \
+        _type = needtypeval;                       \
+        _data.set(std::move(x));                   \
+    }
+
+        _MAKE(double, number_double)
+        _MAKE(int, number_integer)
+        _MAKE(bool, boolean)
+        _MAKE(string_t, string)
+
+    #undef _MAKE
+
+        void assign()
+        {
+            _type = null;
+            _data.clear();
+        }
+        void assign(std::nullptr_t) { _type = null; }
+        void assign(const string_char_t *x) { assign(string_t(x)); }
+        void assign(const value &x)
+        {
+            _type = x._type;
+            _data = x._data;
+        }
+
+        void clear()
+        {
+            switch (_type)
+            {
+            case number_double:
+                as<double>() = 0;
+            case number_integer:
+                as<int>() = 0;
+            case string:
+                as<string_t>().clear();
+            case boolean:
+                as<bool>() = 0;
+            }
+        }
+
+        std::string to_string() const
+        {
+            switch (_type)
+            {
+            case number_double:
+                return std::to_string(_data.template as<double>());
+            case number_integer:
+                return std::to_string(_data.template as<int>());
+            case string:
+                return _data.template as<string_t>();
+            case null:
+                return "null";
+            case boolean:
+                return _data.template as<bool>() ? "true" : "false";
+            }
+            return "unknown";
+        }
+
+        inline int type() const { return _type; }
+        static const char *type_name(int type)
+        {
+            switch (type)
+            {
+            case number_double:
+            case number_integer:
+                return "value::number";
+            case string:
+                return "value::string";
+            case null:
+                return "value::null";
+            case boolean:
+                return "value::boolean";
+            }
+            return "unknown";
+        }
+        const char *type_name() const { return type_name(_type); }
+
+    private:
+        void ensure_is(int type) const
+        {
+            if (_type != type && _type != null)
+                _SJSON_THROW_TYPE_ADJUST_RAW(type_name(), type_name(type));
+        }
+        friend class json_base;
+        friend class json_base::_my_initializer_list;
+        int _type;
+        // std::string 自带短字符串优化，短字符串因此直接存放在结点中
+        _fake_union<sizeof(string_t)> _data;
+    };
+
+    using object=std::unordered_map<string_t, json_base>;
+    // class object : public std::unordered_map<string_t, json_base>
+    // {
+    // public:
+    // };
+    // 半开区间 [first, last)，用于 range-based for
+    template <typename _iter_t>
+    class range
+    {
+    public:
+        range(_iter_t first, _iter_t last) : _first(first), _last(last) {}
+        _iter_t begin() const { return _first; }
+        _iter_t end() const { return _last; }
+        bool empty() const { return _first == _last; }
+
+    private:
+        _iter_t _first, _last;
+    };
+
+    /*
+    * array 中元素按 _t 读取的视图，规则同 try_get<_t>()
+    * 每个元素只检查一次类型，仅在类型不符时抛出 json_error
+    * 对打包存储的 array（见 pack()）直接读取连续的数值
+    */
+    template <typename _t>
+    class value_view
+    {
+    public:
+        // 数值按值返回，其余类型返回指向结点内数据的引用
+        using reference = typename std::conditional<
+            std::is_arithmetic<_t>::value, _t, const _t &>::type;
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = _t;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const _t *;
+            using reference = value_view::reference;
+
+            iterator() : _p(nullptr), _kind(value::null) {}
+            // kind 为 value::null 时元素为 json_base，否则为打包存储的数值类型
+            iterator(const void *p, int kind)
+                : _p(static_cast<const char *>(p)), _kind(kind) {}
+
+            reference operator*() const
+            {
+                if (_kind != value::null)
+                    return _packed(static_cast<_t *>(nullptr));
+                const json_base *node = reinterpret_cast<const json_base *>(_p);
+                auto res = node->template try_get<_t>();
+                if (!res)
+                    _SJSON_THROW(std::string("element is ") + node->type_name());
+                return *res;
+            }
+            reference operator[](difference_type n) const { return *(*this + n); }
+
+            iterator &operator++() { _p += _stride(); return *this; }
+            iterator operator++(int) { iterator x = *this; ++*this; return x; }
+            iterator &operator--() { _p -= _stride(); return *this; }
+            iterator operator--(int) { iterator x = *this; --*this; return x; }
+            iterator &operator+=(difference_type n) { _p += n * _stride(); return *this; }
+            iterator &operator-=(difference_type n) { _p -= n * _stride(); return *this; }
+            iterator operator+(difference_type n) const { return iterator(_p + n * _stride(), _kind); }
+            iterator operator-(difference_type n) const { return iterator(_p - n * _stride(), _kind); }
+            difference_type operator-(const iterator &x) const { return (_p - x._p) / difference_type(_stride()); }
+
+            bool operator==(const iterator &x) const { return _p == x._p; }
+            bool operator!=(const iterator &x) const { return _p != x._p; }
+            bool operator<(const iterator &x) const { return _p < x._p; }
+            bool operator>(const iterator &x) const { return _p > x._p; }
+            bool operator<=(const iterator &x) const { return _p <= x._p; }
+            bool operator>=(const iterator &x) const { return _p >= x._p; }
+
+        private:
+            const char *_p;
+            int _kind;
+
+            inline size_t _stride() const
+            {
+                return _kind == value::null
+                           ? sizeof(json_base)
+                           : (_kind == value::number_double ? sizeof(double) : sizeof(int));
+            }
+            // 打包的元素只能按 double 或 int 读取
+            double _packed(double *) const
+            {
+                if (_kind == value::number_double)
+                    return *reinterpret_cast<const double *>(_p);
+                return *reinterpret_cast<const int *>(_p);
+            }
+            int _packed(int *) const
+            {
+                if (_kind != value::number_integer)
+                    _SJSON_THROW("element is value::number");
+                return *reinterpret_cast<const int *>(_p);
+            }
+            template <typename _u>
+            reference _packed(_u *) const
+            {
+                _SJSON_THROW("element is value::number");
+            }
+        };
+
+        value_view(const json_base *first, const json_base *last)
+            : _first(first, value::null), _last(last, value::null) {}
+        template <typename _u>
+        value_view(const _u *first, const _u *last, int kind)
+            : _first(first, kind), _last(last, kind) {}
+        iterator begin() const { return _first; }
+        iterator end() const { return _last; }
+        size_t size() const { return _last - _first; }
+        bool empty() const { return _first == _last; }
+        reference operator[](size_t idx) const { return _first[idx]; }
+
+    private:
+        iterator _first, _last;
+    };
+
+    // 元素较少的 array 不再额外分配内存
+    class array : public _small_vector<json_base, 4>
+    {
+    public:
+        using _base_t = _small_vector<json_base, 4>;
+        array() : _base_t() {}
+        array(std::initializer_list<_my_initializer_list> x)
+        {
+            for (auto &it : x)
+                this->push_back(it.data());
+        }
+        explicit array(size_t n) : _base_t(n) {}
+        array(size_t n, const json_base &x) : _base_t(n, x) {}
+        template <
+            typename _iter_t,
+            typename std::enable_if<
+                !std::is_integral<_iter_t>::value, int
+            >::type = 0
+        > array(_iter_t first, _iter_t last) : _base_t(first, last) {}
+        // 不再是 std::vector ，只能通过复制相互转换
+        array(const std::vector<json_base> &x) : _base_t(x.begin(), x.end()) {}
+        operator std::vector<json_base>() const
+        {
+            return std::vector<json_base>(this->begin(), this->end());
+        }
+
+        template <typename _t>
+        value_view<_t> values() const
+        {
+            return value_view<_t>(this->data(), this->data() + this->size());
+        }
+        /*
+        * 将全部元素按 _t 批量写入 dest（至少需要 size() 个元素的空间）
+        * 遇到类型不符的元素时返回 false，不抛出异常
+        */
+        template <typename _t>
+        bool copy_values(_t *dest) const
+        {
+            for (const auto &it : *this)
+            {
+                auto res = it.template try_get<_t>();
+                if (!res)
+                    return false;
+                *dest++ = *res;
+            }
+            return true;
+        }
+        template <typename _t>
+        bool copy_values(std::vector<_t> &dest) const
+        {
+            dest.clear();
+            dest.reserve(this->size());
+            for (const auto &it : *this)
+            {
+                auto res = it.template try_get<_t>();
+                if (!res)
+                    return false;
+                dest.push_back(*res);
+            }
+            return true;
+        }
+    };
+
+    json_base() : _type(json_type::value), _data(value()) {}
+    json_base(const json_base &x) { _assign(x); }
+    json_base(json_base &&x) noexcept
+        : _type(x._type), _data(std::move(x._data)),
+          _hash_cache(x._hash_cache.load(std::memory_order_relaxed))
+    {
+        x._type = json_type::value;
+    }
+    json_base(const array &x) { _assign(x); }
+    json_base(const object &x) { _assign(x); }
+    json_base(std::initializer_list<_my_initializer_list> x)
+    {
+        _assign(_my_initializer_list(x));
+    }
+    template <
+        typename _t,
+        typename std::enable_if<
+            std::is_constructible<value, _t>::value, int
+        >::type = 0
+    > json_base(const _t &x) { _assign(value(x)); }
+
+    const json_base &operator=(const json_base &x)
+    {
+        _assign(x);
+        return x;
+    }
+    json_base &operator=(json_base &&x) noexcept
+    {
+        _type = x._type;
+        _data = std::move(x._data);
+        _hash_cache.store(
+            x._hash_cache.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+        x._type = json_type::value;
+        return *this;
+    }
+    const array &operator=(const array &x)
+    {
+        _assign(x);
+        return x;
+    }
+    const object &operator=(const object &x)
+    {
+        _assign(x);
+        return x;
+    }
+    const std::initializer_list<_my_initializer_list> &
+    operator=(const std::initializer_list<_my_initializer_list> &x)
+    {
+        _assign(_my_initializer_list(x));
+        return x;
+    }
+
+    inline operator const array &() const { return as_array(); }
+    inline operator const object &() const { return as_object(); }
+    template <
+        typename _t,
+        typename std::enable_if<
+            !(
+                // 消除 string 歧义
+                std::is_pointer<_t>::value // [const] char* [const]
+                || std::is_same<_t, string_char_t>::value
+                || std::is_same<_t,
+                    std::initializer_list<string_char_t>
+                    >::value
+            ), int
+        >::type = 0
+    > inline operator _t () const{return _t(as_value());}
+
+    inline friend std::ostream &operator<<(std::ostream &os, const json_base &j)
+    {
+        // 宽度很小，一般不会超出 std::string 的内联缓冲区
+        dump_options opt;
+        opt.indent.assign(os.width(), ' ');
+        os.width(0);
+        std::string res;
+        j.dump(res, opt);
+        return os.write(res.data(), res.size());
+    }
+
+#if defined(_SJSON_DISABLE_AUTO_TYPE_ADJUST)
+#define _ENSURE_IS(t) _SJSON_TRY(_ensure_is(t))
+#else
+#define _ENSURE_IS(t) ((void)0)
+#endif
+
+    json_base &operator[](size_t idx)
+    {
+        _ENSURE_IS(json_type::array);
+        
+        if (!is_array())
+        {
+            _type = json_type::array;
+            _data.set(array());
+        }
+        return as_array()[idx];
+    }
+    const json_base &operator[](size_t idx) const
+    {
+        _ENSURE_IS(json_type::array);
+        return as_array()[idx];
+    }
+
+    /*
+    * 修改 array 的元素，打包存储的 array 在元素类型相同时保持打包，
+    * 否则先转换回普通的 array
+    */
+    void push_back(const json_base &x)
+    {
+        _ENSURE_IS(json_type::array);
+        if (!is_array())
+        {
+            _type = json_type::array;
+            _data.set(array());
+        }
+        _invalidate_hash();
+        if (!_packed_push_back(x))
+        {
+            _unpack_self();
+            _data.template get<array>().push_back(x);
+        }
+    }
+    void set(size_t idx, const json_base &x)
+    {
+        _ENSURE_IS(json_type::array);
+        if (!is_array() || idx >= _array_size())
+            _SJSON_THROW("array index out of range: " + std::to_string(idx));
+        _invalidate_hash();
+        if (!_packed_set(idx, x))
+        {
+            _unpack_self();
+            _data.template get<array>()[idx] = x;
+        }
+    }
+
+    // 不使用 char* 以防止 0 被识别成 C 风格字符串
+    template <typename _t>
+    json_base &operator[](const _t *const key)
+    {
+        return this->operator[](std::move(string_t(key)));
+    }
+    template <typename _t>
+    const json_base &operator[](const _t *const key)const
+    {
+        return this->operator[](std::move(string_t(key)));
+    }
+
+    json_base &operator[](const string_t &key)
+    {
+        _ENSURE_IS(json_type::object);
+        if (!is_object())
+        {
+            _type = json_type::object;
+            _data.set(object());
+        }
+        return as_object()[key];
+    }
+    const json_base &operator[](const string_t &key) const
+    {
+        _ENSURE_IS(json_type::object);
+        static json_base _empty_res;
+        const auto &obj = as_object();
+        const auto &it = obj.find(key);
+        if (it != obj.end())
+            return it->second;
+        return _empty_res;
+    }
+
+    inline json_type type() const { return _type; }
+    std::string type_name()const
+    {
+        if(is_value())
+        {
+            return as_value().type_name();
+        }
+        else return json_type_name(_type);
+    }
+    inline bool is_value() const { return _type == json_type::value; }
+    inline bool is_array() const { return _type == json_type::array; }
+    inline bool is_object() const { return _type == json_type::object; }
+
+    /*
+    * 返回可修改的引用，因此会使该结点缓存的哈希值失效
+    * 打包存储的 array 会先转换回普通的 array ，见 pack()
+    */
+    inline array &as_array()
+    {
+        _ENSURE_IS(json_type::array);
+        _invalidate_hash();
+        _unpack_self();
+        return _data.template as<array>();
+    }
+    inline object &as_object()
+    {
+        _ENSURE_IS(json_type::object);
+        _invalidate_hash();
+        return _data.template as<object>();
+    }
+    inline value &as_value()
+    {
+        _ENSURE_IS(json_type::value);
+        _invalidate_hash();
+        return _data.template as<value>();
+    }
+
+    // 打包存储的 array 返回只读副本，不改变存储
+    inline const array &as_array() const
+    {
+        _ENSURE_IS(json_type::array);
+        if (is_packed())
+            return _packed_mirror();
+        return _data.template as<array>();
+    }
+    inline const object &as_object() const
+    {
+        _ENSURE_IS(json_type::object);
+        return _data.template as<object>();
+    }
+    inline const value &as_value() const
+    {
+        _ENSURE_IS(json_type::value);
+        return _data.template as<value>();
+    }
+
+#undef _ENSURE_IS
+
+    bool empty() const
+    {
+        if (is_array())
+            return _array_size() == 0;
+        if (is_object())
+            return as_object().empty();
+        return _data.empty();
+    }
+    void clear()
+    {
+        if (is_packed())
+        {
+            _invalidate_hash();
+            _data.set(array());
+        }
+        else if (is_array())
+            as_array().clear();
+        else if (is_object())
+            as_object().clear();
+        else if (is_value())
+            as_value().clear();
+        else
+            _data.clear();
+    }
+
+    inline json_base &at(size_t idx) { return as_array().at(idx); }
+    inline const json_base &at(size_t idx) const { return as_array().at(idx); }
+    inline json_base &at(string_t key) { return as_object().at(key); }
+    inline const json_base &at(string_t key) const { return as_object().at(key); }
+
+    // try_get/find 的返回值，类似 expected<const _t &, int>
+    template <typename _t>
+    class result
+    {
+    public:
+        explicit operator bool() const { return _error == parser::no_error; }
+        // 失败时为 parser::type_error 或 parser::not_found
+        int error() const { return _error; }
+        const _t &operator*() const { return _deref(_data); }
+        const _t *operator->() const { return &_deref(_data); }
+        _t value_or(const _t &x) const { return *this ? _deref(_data) : x; }
+
+    private:
+        friend class json_base;
+        // 数值直接保存，其余类型保存指向结点内数据的指针
+        using _storage_t = typename std::conditional<
+            std::is_arithmetic<_t>::value, _t, const _t *>::type;
+
+        result(_storage_t x, int error) : _data(x), _error(error) {}
+        static result _ok(_storage_t x) { return result(x, parser::no_error); }
+        static result _fail(int error) { return result(_storage_t(), error); }
+
+        static const _t &_deref(const _t &x) { return x; }
+        static const _t &_deref(const _t *x) { return *x; }
+
+        _storage_t _data;
+        int _error;
+    };
+
+    /*
+    * 不抛出异常的类型检查与取值，类型不符时返回 parser::type_error
+    * 与 as<> 不同，null 不会被当作任意类型的默认值；
+    * try_get<double> 也接受 number_integer
+    */
+    template <typename _t>
+    result<_t> try_get() const
+    {
+        return _try_get(static_cast<_t *>(nullptr));
+    }
+    result<json_base> find(const string_t &key) const
+    {
+        if (!is_object())
+            return result<json_base>::_fail(parser::type_error);
+        const auto &obj = _data.template get<object>();
+        auto it = obj.find(key);
+        if (it == obj.end())
+            return result<json_base>::_fail(parser::not_found);
+        return result<json_base>::_ok(&it->second);
+    }
+    result<json_base> find(size_t idx) const
+    {
+        if (!is_array())
+            return result<json_base>::_fail(parser::type_error);
+        const auto &arr = as_array();
+        if (idx >= arr.size())
+            return result<json_base>::_fail(parser::not_found);
+        return result<json_base>::_ok(&arr[idx]);
+    }
+
+    // 不是 array 时返回空的视图
+    template <typename _t>
+    value_view<_t> values() const
+    {
+        switch (_packed_kind())
+        {
+        case value::number_double:
+        {
+            const auto &x = _data.template get<_packed_double>().data;
+            return value_view<_t>(x.data(), x.data() + x.size(), value::number_double);
+        }
+        case value::number_integer:
+        {
+            const auto &x = _data.template get<_packed_int>().data;
+            return value_view<_t>(x.data(), x.data() + x.size(), value::number_integer);
+        }
+        }
+        if (!is_array())
+            return value_view<_t>(nullptr, nullptr);
+        return _data.template get<array>().template values<_t>();
+    }
+    /*
+    * 将 array 的全部元素按 _t 取出，类型不符时返回 false
+    * 打包存储的 array 直接整块复制
+    */
+    template <typename _t>
+    bool copy_values(std::vector<_t> &dest) const
+    {
+        if (_packed_kind() != value::null)
+            return _copy_packed(dest);
+        if (!is_array())
+            return false;
+        return _data.template get<array>().copy_values(dest);
+    }
+
+    /*
+    * 将子树中只包含 number_double 或只包含 number_integer 的 array 改为连续存储，
+    * 每个元素只占 sizeof(double)/sizeof(int)
+    * 读取使用 values<T>()、copy_values()、dump()、hash() 与 operator== ，
+    * 修改使用 push_back()/set() ；const 的 as_array()、operator[]、at 读取一份
+    * 按需创建的只读副本，非 const 的结点访问会先转换回普通的 array
+    * 定义 _SJSON_PACK_NUMERIC_ARRAYS 后解析时会自动打包
+    */
+    void pack()
+    {
+        if (is_object())
+        {
+            for (auto &it : _data.template get<object>())
+                it.second.pack();
+            return;
+        }
+        if (!is_array() || _packed_kind() != value::null)
+            return;
+        for (auto &it : _data.template get<array>())
+            it.pack();
+        _pack_self();
+    }
+    // 将子树中打包存储的 array 转换回普通的 array
+    void unpack()
+    {
+        _invalidate_hash();
+        _unpack_self();
+        if (is_array())
+            for (auto &it : _data.template get<array>())
+                it.unpack();
+        else if (is_object())
+            for (auto &it : _data.template get<object>())
+                it.second.unpack();
+    }
+    // 该结点是否为打包存储的 array
+    inline bool is_packed() const { return _packed_kind() != value::null; }
+    // object 的键值对，不是 object 时返回空的区间
+    range<typename object::const_iterator> items() const
+    {
+        static const object empty_obj;
+        const object &obj = is_object() ? _data.template get<object>() : empty_obj;
+        return range<typename object::const_iterator>(obj.begin(), obj.end());
+    }
+
+    struct dump_options
+    {
+        // 每层缩进的内容，为空则输出紧凑格式（不换行）
+        string_t indent = "  ";
+        bool space_after_colon = true;
+        // 仅在紧凑格式下生效
+        bool space_after_comma = false;
+        bool sort_keys = false;
+        // 将非 ASCII 字符输出为 \uXXXX
+        bool ascii_only = false;
+        /*
+        * RFC 8785 规范化输出：紧凑格式，键按 UTF-16 码元排序，
+        * 数字使用最短的可往返表示。开启后忽略其余选项
+        */
+        bool canonical = false;
+    };
+
+    std::string dump(const std::string &tab = "  ") const
+    {
+        std::string res;
+        dump(res, tab);
+        return res;
+    }
+    std::string dump(const dump_options &opt) const
+    {
+        std::string res;
+        dump(res, opt);
+        return res;
+    }
+    void dump(std::string &dest, const dump_options &opt) const
+    {
+        _dumper(dest, opt).write(*this, 0);
+    }
+    void dump(std::string &dest, const std::string &tab = "  ", int deep = 0) const
+    {
+        dump_options opt;
+        opt.indent = tab;
+        _dumper d(dest, opt);
+        // 规定如果 deep < 0 则此次不输出前导缩进（用于 object 的输出）
+        if (deep < 0)
+            deep = -deep;
+        else
+            d.indent(deep);
+        d.write(*this, deep);
+    }
+    // 不抛出异常的接口使用的错误信息
+    class error_code
+    {
+    public:
+        int kind = parser::no_error;
+        size_t offset = 0;
+        size_t line = 0, column = 0;
+        // 指向静态字符串，记录错误时不分配内存
+        const char *message = "";
 
+        explicit operator bool() const { return kind != parser::no_error; }
         std::string to_string() const
         {
-            switch (_type)
+            return std::string(parser::error_name(kind)) +
+                   " at line " + std::to_string(line) +
+                   ", column " + std::to_string(column) +
+                   " (offset " + std::to_string(offset) + "): " + message;
+        }
+    };
+
+    class parser
+    {
+    public:
+        enum class node_t
+        {
+            object,
+            object_node,
+            array,
+            value
+        };
+        enum
+        {
+            no_error = -1,
+            syntax_error,
+            range_error, // 数字超出范围
+            type_error,  // 访问时类型不符
+            not_found    // 键或下标不存在
+        };
+        // 返回 true/false 以确定是否保留
+        using filter = std::function<bool(node_t, json_base &)>;
+
+        /*
+        * 返回 true/false 以决定是否继续
+        * 每个错误都会通知回调，但只有 range_error 可以继续（数值取 ±HUGE_VAL）
+        */
+        using error_callback_f = std::function<bool(int)>;
+
+        static const char *error_name(int kind)
+        {
+            switch (kind)
             {
-            case number_double:
-                return std::to_string(_data.as<double>());
-            case number_integer:
-                return std::to_string(_data.as<int>());
-            case string:
-                return _data.as<string_t>();
-            case null:
-                return "null";
-            case boolean:
-                return _data.as<bool>() ? "true" : "false";
+            case no_error:
+                return "no error";
+            case syntax_error:
+                return "syntax error";
+            case range_error:
+                return "range error";
+            case type_error:
+                return "type error";
+            case not_found:
+                return "not found";
             }
-            return "unknown";
+            return "unknown error";
         }
 
-        inline int type() const { return _type; }
-        static const char *type_name(int type)
+        // 解析时使用的临时缓冲区，document 在多次解析之间保留它们的容量
+        struct buffers
         {
-            switch (type)
+            string_t key;
+            std::string number;
+            std::vector<json_base *> seen; // 复用 object 时记录出现过的结点
+        };
+
+        /*
+        * 出错时返回 false 并填写 ec，不抛出异常
+        * res 中原有的结点、字符串与容器会被尽量复用
+        */
+        template <typename _iter_t>
+        static bool parse(
+            json_base &res, _iter_t first, _iter_t last, error_code &ec,
+            buffers &bufs, const error_callback_f &on_error = error_callback_f())
+        {
+            ec = error_code();
+            bufs.seen.clear();
+            _impl<_iter_t> p(first, last, ec, bufs, on_error);
+            return p.parse_document(res);
+        }
+        template <typename _iter_t>
+        static bool parse(
+            json_base &res, _iter_t first, _iter_t last, error_code &ec,
+            const error_callback_f &on_error = error_callback_f())
+        {
+            buffers bufs;
+            return parse(res, first, last, ec, bufs, on_error);
+        }
+        template <typename _iter_t>
+        static void parse(
+            json_base &res, _iter_t first, _iter_t last)
+        {
+            error_code ec;
+            if (!parse(res, first, last, ec))
+                _SJSON_THROW(ec.to_string());
+        }
+
+        /*
+        * 两阶段并行解析（仅对顶层为 array 的文档生效，否则退化为 parse）
+        * 1. 分块并行查找引号，跨块传递字符串奇偶性后再并行找出结构字符，
+        *    得到顶层 array 各元素的边界
+        * 2. 多线程分别解析各元素，直接写入结果 array 的对应位置
+        * threads 为 0 时使用 std::thread::hardware_concurrency()
+        * 出错时会重新串行解析整个文档以得到准确的错误位置
+        */
+        static bool parse_parallel(
+            json_base &res, const char *first, const char *last,
+            error_code &ec, unsigned threads = 0)
+        {
+            // 小于该大小的文档并行收益不足以抵消线程开销
+            const size_t min_parallel_size = 1 << 20;
+            if (threads == 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads < 2 || size_t(last - first) < min_parallel_size)
+                return parse(res, first, last, ec);
+
+            const char *lb = first, *rb = last;
+            while (lb != rb && _is_blank(*lb))
+                ++lb;
+            while (rb != lb && _is_blank(rb[-1]))
+                --rb;
+            // 格式不符时交给串行解析器报告具体错误
+            if (rb - lb < 2 || *lb != '[' || rb[-1] != ']')
+                return parse(res, first, last, ec);
+            const char *begin = lb + 1, *end = rb - 1;
+
+            size_t chunk_cnt = threads;
+            size_t chunk_size = (end - begin + chunk_cnt - 1) / chunk_cnt;
+            std::vector<_chunk> chunks(chunk_cnt);
+            for (size_t i = 0; i < chunk_cnt; ++i)
             {
-            case number_double:
-            case number_integer:
-                return "value::number";
-            case string:
-                return "value::string";
-            case null:
-                return "value::null";
-            case boolean:
-                return "value::boolean";
+                chunks[i].first = begin + std::min(i * chunk_size, size_t(end - begin));
+                chunks[i].last = begin + std::min((i + 1) * chunk_size, size_t(end - begin));
             }
-            return "unknown";
+
+            // 阶段 1a：统计每块中未转义的引号数
+            _run_parallel(chunk_cnt, threads, [&](size_t i)
+            { chunks[i].count_quotes(begin); });
+            bool in_string = false;
+            for (auto &c : chunks)
+            {
+                c.in_string = in_string;
+                in_string ^= (c.quotes & 1) != 0;
+            }
+            if (in_string)
+                return parse(res, first, last, ec);
+
+            // 阶段 1b：在已知的字符串状态下收集结构字符
+            _run_parallel(chunk_cnt, threads, [&](size_t i)
+            { chunks[i].collect_structurals(begin); });
+            long depth = 0;
+            for (auto &c : chunks)
+            {
+                c.depth = depth;
+                depth += c.depth_delta;
+            }
+            if (depth != 0)
+                return parse(res, first, last, ec);
+
+            // 阶段 1c：找出深度为 0 的逗号作为元素分界
+            std::atomic<bool> failed(false);
+            _run_parallel(chunk_cnt, threads, [&](size_t i)
+            {
+                if (!chunks[i].collect_splits())
+                    failed = true;
+            });
+            if (failed)
+                return parse(res, first, last, ec);
+
+            std::vector<const char *> splits;
+            splits.push_back(begin - 1);
+            for (auto &c : chunks)
+                splits.insert(splits.end(), c.splits.begin(), c.splits.end());
+            splits.push_back(end);
+
+            ec = error_code();
+            res = array();
+            auto &arr = res.as_array();
+            size_t elem_cnt = splits.size() - 1;
+            if (elem_cnt == 1)
+            {
+                const char *p = begin;
+                while (p != end && _is_blank(*p))
+                    ++p;
+                if (p == end)
+                    return true;
+            }
+            arr.resize(elem_cnt);
+
+            // 阶段 2：多线程解析各元素，按批分发以减少任务调度开销
+            size_t batch = std::max(size_t(1), elem_cnt / (size_t(threads) * 16));
+            _run_parallel((elem_cnt + batch - 1) / batch, threads, [&](size_t b)
+            {
+                error_code elem_ec;
+                buffers bufs;
+                error_callback_f no_callback;
+                size_t i = b * batch, e = std::min(elem_cnt, i + batch);
+                for (; i < e && !failed; ++i)
+                {
+                    _impl<const char *> p(splits[i] + 1, splits[i + 1], elem_ec, bufs, no_callback);
+                    p.depth = 1; // 元素位于顶层 array 中
+                    if (!p.parse_document(arr[i]))
+                        failed = true;
+                }
+            });
+            if (failed)
+                return parse(res, first, last, ec);
+#ifdef _SJSON_PACK_NUMERIC_ARRAYS
+            res._pack_self();
+#endif
+            return true;
+        }
+        static void parse_parallel(
+            json_base &res, const char *first, const char *last,
+            unsigned threads = 0)
+        {
+            error_code ec;
+            if (!parse_parallel(res, first, last, ec, threads))
+                _SJSON_THROW(ec.to_string());
         }
-        const char *type_name() const { return type_name(_type); }
 
     private:
-        void ensure_is(int type) const
+        template <typename _iter_t>
+        class _impl
         {
-            if (_type != type && _type != null)
-                _SJSON_THROW_TYPE_ADJUST_RAW(type_name(), type_name(type));
-        }
-        friend class json_base::_my_initializer_list;
-        int _type;
-        _fake_union _data;
-    };
+        public:
+            _impl(_iter_t first, _iter_t last, error_code &ec, buffers &bufs,
+                  const error_callback_f &on_error)
+                : it(first), last(last), ec(ec), bufs(bufs), on_error(on_error) {}
+
+            _iter_t it, last;
+            size_t pos = 0, line = 1, line_start = 0;
+            error_code &ec;
+            buffers &bufs;
+            size_t depth = 0;
+            const error_callback_f &on_error;
+
+            // at 须位于当前行内
+            void record(int kind, const char *msg, size_t at)
+            {
+                ec.kind = kind;
+                ec.message = msg;
+                ec.offset = at;
+                ec.line = line;
+                ec.column = at - line_start + 1;
+            }
+            // 记录错误并通知回调，总是返回 false
+            bool fail(int kind, const char *msg)
+            {
+                record(kind, msg, pos);
+                if (on_error)
+                    on_error(kind);
+                return false;
+            }
+            // 可恢复的错误：回调返回 true 时忽略该错误并继续解析
+            bool recoverable(int kind, const char *msg, size_t at)
+            {
+                record(kind, msg, at);
+                if (on_error && on_error(kind))
+                {
+                    ec = error_code();
+                    return true;
+                }
+                return false;
+            }
 
-    using object=std::unordered_map<string_t, json_base>;
-    // class object : public std::unordered_map<string_t, json_base>
-    // {
-    // public:
-    // };
-    class array : public std::vector<json_base>
-    {
-    public:
-        using _base_t = std::vector<json_base>;
-        array() : _base_t() {}
-        array(std::initializer_list<_my_initializer_list> x)
+            inline bool eof() const { return it == last; }
+            inline char peek() const { return static_cast<char>(*it); }
+            inline char next()
+            {
+                char c = static_cast<char>(*it);
+                ++it, ++pos;
+                if (c == '\n')
+                    ++line, line_start = pos;
+                return c;
+            }
+            void skip_blank()
+            {
+                while (!eof() && _is_blank(peek()))
+                    next();
+            }
+            bool expect(char c, const char *msg)
+            {
+                if (eof() || peek() != c)
+                    return fail(syntax_error, msg);
+                next();
+                return true;
+            }
+            bool expect_word(const char *word)
+            {
+                for (; *word; ++word)
+                    if (!expect(*word, "invalid literal"))
+                        return false;
+                return true;
+            }
+
+            bool parse_document(json_base &res)
+            {
+                skip_blank();
+                if (!parse_node(res))
+                    return false;
+                skip_blank();
+                if (!eof())
+                    return fail(syntax_error, "unexpected trailing characters");
+                return true;
+            }
+
+            bool parse_node(json_base &res)
+            {
+                if (eof())
+                    return fail(syntax_error, "unexpected end of input");
+                switch (peek())
+                {
+                case '{':
+                case '[':
+                {
+                    // 限制嵌套深度，避免恶意输入耗尽栈空间
+                    if (depth == _SJSON_MAX_DEPTH)
+                        return fail(syntax_error, "maximum nesting depth exceeded");
+                    ++depth;
+                    bool ok = peek() == '{' ? parse_object(res) : parse_array(res);
+                    --depth;
+                    return ok;
+                }
+                case '"':
+                    return parse_string(res._reuse_string());
+                case 't':
+                    res._assign(value(true));
+                    return expect_word("true");
+                case 'f':
+                    res._assign(value(false));
+                    return expect_word("false");
+                case 'n':
+                    res._assign(value(nullptr));
+                    return expect_word("null");
+                }
+                return parse_number(res);
+            }
+
+            bool parse_object(json_base &res)
+            {
+                next();
+                if (!res.is_object())
+                    res._assign(object());
+                auto &obj = res.as_object();
+                // 原先不为空时复用同名键的结点，结束时删除没有出现的键
+                bool reuse = !obj.empty();
+                size_t seen_start = bufs.seen.size();
+                skip_blank();
+                if (!eof() && peek() == '}')
+                {
+                    next();
+                    obj.clear();
+                    return true;
+                }
+                auto &key = bufs.key;
+                for (;;)
+                {
+                    skip_blank();
+                    if (eof() || peek() != '"')
+                        return fail(syntax_error, "expected string as object key");
+                    key.clear();
+                    if (!parse_string(key))
+                        return false;
+                    skip_blank();
+                    if (!expect(':', "expected ':'"))
+                        return false;
+                    skip_blank();
+                    json_base *node;
+                    if (reuse)
+                    {
+                        auto found = obj.find(key);
+                        node = found != obj.end() ? &found->second : &obj[key];
+                        bufs.seen.push_back(node);
+                    }
+                    else
+                        node = &obj[key];
+                    if (!parse_node(*node))
+                        return false;
+                    skip_blank();
+                    if (eof())
+                        return fail(syntax_error, "unterminated object");
+                    if (peek() == '}')
+                    {
+                        next();
+                        if (reuse)
+                            drop_unseen(obj, seen_start);
+                        return true;
+                    }
+                    if (!expect(',', "expected ',' or '}'"))
+                        return false;
+                }
+            }
+
+            void drop_unseen(object &obj, size_t seen_start)
+            {
+                auto first = bufs.seen.begin() + seen_start;
+                std::sort(first, bufs.seen.end());
+                auto last = std::unique(first, bufs.seen.end());
+                if (size_t(last - first) != obj.size())
+                {
+                    for (auto i = obj.begin(); i != obj.end();)
+                    {
+                        if (std::binary_search(first, last, &i->second))
+                            ++i;
+                        else
+                            i = obj.erase(i);
+                    }
+                }
+                bufs.seen.resize(seen_start);
+            }
+
+            bool parse_array(json_base &res)
+            {
+                next();
+                // 打包的 array 不复用，直接替换为普通的 array
+                if (!res.is_array() || res.is_packed())
+                    res._assign(array());
+                auto &arr = res.as_array();
+                skip_blank();
+                if (!eof() && peek() == ']')
+                {
+                    next();
+                    arr.clear();
+                    return true;
+                }
+                // 依次复用原有的元素，结束时删除多余的元素
+                size_t n = 0;
+                for (;;)
+                {
+                    skip_blank();
+                    if (n == arr.size())
+                        arr.push_back(json_base());
+                    if (!parse_node(arr[n++]))
+                        return false;
+                    skip_blank();
+                    if (eof())
+                        return fail(syntax_error, "unterminated array");
+                    if (peek() == ']')
+                    {
+                        next();
+                        arr.erase(arr.begin() + n, arr.end());
+#ifdef _SJSON_PACK_NUMERIC_ARRAYS
+                        res._pack_self();
+#endif
+                        return true;
+                    }
+                    if (!expect(',', "expected ',' or ']'"))
+                        return false;
+                }
+            }
+
+            bool parse_string(string_t &dest)
+            {
+                next();
+                for (;;)
+                {
+                    if (eof())
+                        return fail(syntax_error, "unterminated string");
+                    char c = peek();
+                    if (c == '"')
+                    {
+                        next();
+                        return true;
+                    }
+                    if (static_cast<unsigned char>(c) < 0x20)
+                        return fail(syntax_error, "control character in string");
+                    next();
+                    if (c != '\\')
+                    {
+                        dest += c;
+                        continue;
+                    }
+                    if (eof())
+                        return fail(syntax_error, "unterminated string");
+                    switch (peek())
+                    {
+                    case '"': dest += '"'; break;
+                    case '\\': dest += '\\'; break;
+                    case '/': dest += '/'; break;
+                    case 'b': dest += '\b'; break;
+                    case 'f': dest += '\f'; break;
+                    case 'n': dest += '\n'; break;
+                    case 'r': dest += '\r'; break;
+                    case 't': dest += '\t'; break;
+                    case 'u':
+                        next();
+                        if (!parse_unicode_escape(dest))
+                            return false;
+                        continue;
+                    default:
+                        return fail(syntax_error, "invalid escape sequence");
+                    }
+                    next();
+                }
+            }
+
+            bool parse_hex4(unsigned &res)
+            {
+                res = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (eof())
+                        return fail(syntax_error, "unterminated \\u escape");
+                    char c = peek();
+                    res <<= 4;
+                    if (c >= '0' && c <= '9')
+                        res |= c - '0';
+                    else if (c >= 'a' && c <= 'f')
+                        res |= c - 'a' + 10;
+                    else if (c >= 'A' && c <= 'F')
+                        res |= c - 'A' + 10;
+                    else
+                        return fail(syntax_error, "invalid hex digit in \\u escape");
+                    next();
+                }
+                return true;
+            }
+            bool parse_unicode_escape(string_t &dest)
+            {
+                unsigned cp;
+                if (!parse_hex4(cp))
+                    return false;
+                if (cp >= 0xD800 && cp <= 0xDBFF)
+                {
+                    // 高代理项后必须紧跟低代理项
+                    unsigned lo;
+                    if (!expect('\\', "expected low surrogate") ||
+                        !expect('u', "expected low surrogate") ||
+                        !parse_hex4(lo))
+                        return false;
+                    if (lo < 0xDC00 || lo > 0xDFFF)
+                        return fail(syntax_error, "invalid utf-16 surrogate pair");
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                }
+                else if (cp >= 0xDC00 && cp <= 0xDFFF)
+                    return fail(syntax_error, "invalid utf-16 surrogate pair");
+                _append_utf8(dest, cp);
+                return true;
+            }
+
+            bool digits(std::string &buf)
+            {
+                if (eof() || !isdigit(static_cast<unsigned char>(peek())))
+                    return fail(syntax_error, "expected digit");
+                while (!eof() && isdigit(static_cast<unsigned char>(peek())))
+                    buf += next();
+                return true;
+            }
+            bool parse_number(json_base &res)
+            {
+                auto &buf = bufs.number;
+                buf.clear();
+                bool is_integer = true;
+                size_t start = pos;
+                if (!eof() && peek() == '-')
+                    buf += next();
+                if (!eof() && peek() == '0')
+                    buf += next();
+                else if (!digits(buf))
+                    return false;
+                if (!eof() && peek() == '.')
+                {
+                    is_integer = false;
+                    buf += next();
+                    if (!digits(buf))
+                        return false;
+                }
+                if (!eof() && (peek() == 'e' || peek() == 'E'))
+                {
+                    is_integer = false;
+                    buf += next();
+                    if (!eof() && (peek() == '+' || peek() == '-'))
+                        buf += next();
+                    if (!digits(buf))
+                        return false;
+                }
+
+                if (is_integer)
+                {
+                    errno = 0;
+                    long long x = strtoll(buf.c_str(), nullptr, 10);
+                    if (errno == 0 && x >= INT_MIN && x <= INT_MAX)
+                    {
+                        res._assign(value(static_cast<int>(x)));
+                        return true;
+                    }
+                }
+                errno = 0;
+                double x = strtod(buf.c_str(), nullptr);
+                res._assign(value(x));
+                if (errno == ERANGE && (x == HUGE_VAL || x == -HUGE_VAL))
+                    return recoverable(range_error, "number out of range", start);
+                return true;
+            }
+        };
+
+        static inline bool _is_blank(char c)
         {
-            for (auto &it : x)
-                this->push_back(it.data());
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+        static void _append_utf8(string_t &dest, unsigned cp)
+        {
+            if (cp < 0x80)
+                dest += static_cast<char>(cp);
+            else if (cp < 0x800)
+            {
+                dest += static_cast<char>(0xC0 | (cp >> 6));
+                dest += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else if (cp < 0x10000)
+            {
+                dest += static_cast<char>(0xE0 | (cp >> 12));
+                dest += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                dest += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else
+            {
+                dest += static_cast<char>(0xF0 | (cp >> 18));
+                dest += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                dest += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                dest += static_cast<char>(0x80 | (cp & 0x3F));
+            }
         }
-    };
 
-    json_base() : _type(json_type::value), _data(value()) {}
-    json_base(const json_base &x) { _assign(x); }
-    json_base(const array &x) { _assign(x); }
-    json_base(const object &x) { _assign(x); }
-    json_base(std::initializer_list<_my_initializer_list> x)
-    {
-        _assign(_my_initializer_list(x));
-    }
-    template <
-        typename _t,
-        typename std::enable_if<
-            std::is_constructible<value, _t>::value, int
-        >::type = 0
-    > json_base(const _t &x) { _assign(value(x)); }
+        struct _chunk
+        {
+            const char *first, *last;
+            size_t quotes = 0;
+            bool in_string = false;
+            long depth = 0, depth_delta = 0;
+            std::vector<const char *> structurals;
+            std::vector<const char *> splits;
+
+            // 块首的转义状态取决于其前方连续 '\' 的个数
+            size_t leading_backslashes(const char *lower) const
+            {
+                size_t cnt = 0;
+                for (const char *p = first; p != lower && p[-1] == '\\'; --p)
+                    ++cnt;
+                return cnt;
+            }
+            void count_quotes(const char *lower)
+            {
+                size_t bs = leading_backslashes(lower);
+                for (const char *p = first; p != last; ++p)
+                {
+                    if (*p == '\\')
+                    {
+                        ++bs;
+                        continue;
+                    }
+                    if (*p == '"' && (bs & 1) == 0)
+                        ++quotes;
+                    bs = 0;
+                }
+            }
+            void collect_structurals(const char *lower)
+            {
+                size_t bs = leading_backslashes(lower);
+                bool in_str = in_string;
+                for (const char *p = first; p != last; ++p)
+                {
+                    char c = *p;
+                    if (c == '\\')
+                    {
+                        ++bs;
+                        continue;
+                    }
+                    if (c == '"' && (bs & 1) == 0)
+                        in_str = !in_str;
+                    else if (!in_str)
+                    {
+                        if (c == '[' || c == '{')
+                            ++depth_delta, structurals.push_back(p);
+                        else if (c == ']' || c == '}')
+                            --depth_delta, structurals.push_back(p);
+                        else if (c == ',')
+                            structurals.push_back(p);
+                    }
+                    bs = 0;
+                }
+            }
+            bool collect_splits()
+            {
+                long d = depth;
+                for (const char *p : structurals)
+                {
+                    if (*p == '[' || *p == '{')
+                        ++d;
+                    else if (*p == ']' || *p == '}')
+                    {
+                        if (--d < 0)
+                            return false;
+                    }
+                    else if (d == 0)
+                        splits.push_back(p);
+                }
+                structurals.clear();
+                structurals.shrink_to_fit();
+                return true;
+            }
+        };
 
-    const json_base &operator=(const json_base &x)
+        // 以至多 threads 个线程执行 f(0) ... f(n-1)，并在调用线程重新抛出首个异常
+        template <typename _func_t>
+        static void _run_parallel(size_t n, unsigned threads, _func_t f)
+        {
+            size_t thread_cnt = std::min(size_t(threads), n);
+            std::atomic<size_t> next_task(0);
+            std::exception_ptr err;
+            std::mutex err_mutex;
+            auto worker = [&]()
+            {
+                for (size_t i; (i = next_task++) < n;)
+                {
+                    try
+                    {
+                        f(i);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(err_mutex);
+                        if (!err)
+                            err = std::current_exception();
+                        next_task = n;
+                    }
+                }
+            };
+            std::vector<std::thread> pool;
+            for (size_t i = 1; i < thread_cnt; ++i)
+                pool.emplace_back(worker);
+            worker();
+            for (auto &t : pool)
+                t.join();
+            if (err)
+                std::rethrow_exception(err);
+        }
+    };
+
+    template <typename _iter_t>
+    static json_base parse(_iter_t first, _iter_t last)
     {
-        _assign(x);
-        return x;
+        json_base res;
+        parser::parse(res, first, last);
+        return res;
     }
-    const array &operator=(const array &x)
+    static json_base parse(const std::string &x)
     {
-        _assign(x);
-        return x;
+        return parse(x.begin(), x.end());
     }
-    const object &operator=(const object &x)
+    template <typename _iter_t>
+    static json_base parse(
+        _iter_t first, _iter_t last, error_code &ec,
+        const typename parser::error_callback_f &on_error =
+            typename parser::error_callback_f())
     {
-        _assign(x);
-        return x;
+        json_base res;
+        parser::parse(res, first, last, ec, on_error);
+        return res;
     }
-    const std::initializer_list<_my_initializer_list> &
-    operator=(const std::initializer_list<_my_initializer_list> &x)
+    static json_base parse(
+        const std::string &x, error_code &ec,
+        const typename parser::error_callback_f &on_error =
+            typename parser::error_callback_f())
     {
-        _assign(_my_initializer_list(x));
-        return x;
+        return parse(x.begin(), x.end(), ec, on_error);
     }
-
-    inline operator const array &() const { return as_array(); }
-    inline operator const object &() const { return as_object(); }
-    template <
-        typename _t,
-        typename std::enable_if<
-            !(
-                // 消除 string 歧义
-                std::is_pointer<_t>::value // [const] char* [const]
-                || std::is_same<_t, string_char_t>::value
-                || std::is_same<_t,
-                    std::initializer_list<string_char_t>
-                    >::value
-            ), int
-        >::type = 0
-    > inline operator _t () const{return _t(as_value());}
-
-    inline friend std::ostream &operator<<(std::ostream &os, const json_base &j)
+    static json_base parse_parallel(const std::string &x, unsigned threads = 0)
     {
-        return os << j.dump(std::string(os.width(), ' '));
+        json_base res;
+        parser::parse_parallel(res, x.data(), x.data() + x.size(), threads);
+        return res;
     }
 
-#if defined(_SJSON_DISABLE_AUTO_TYPE_ADJUST)
-#define _ENSURE_IS(t) _SJSON_TRY(_ensure_is(t))
-#else
-#define _ENSURE_IS(t) ((void)0)
-#endif
-
-    json_base &operator[](size_t idx)
+    /*
+    * 可重复使用的文档：每次解析都写入同一棵树，并保留其中的结点、
+    * 字符串与容器的容量，结构相近的文档反复解析时不再分配内存
+    * 解析出错时 root() 的内容不确定
+    */
+    class document
     {
-        _ENSURE_IS(json_type::array);
-        
-        if (!is_array())
+    public:
+        template <typename _iter_t>
+        bool parse(
+            _iter_t first, _iter_t last, error_code &ec,
+            const typename parser::error_callback_f &on_error =
+                typename parser::error_callback_f())
         {
-            _type = json_type::array;
-            _data.set(array());
+            return parser::parse(_root, first, last, ec, _bufs, on_error);
+        }
+        bool parse(
+            const std::string &x, error_code &ec,
+            const typename parser::error_callback_f &on_error =
+                typename parser::error_callback_f())
+        {
+            return parse(x.begin(), x.end(), ec, on_error);
+        }
+        template <typename _iter_t>
+        json_base &parse(_iter_t first, _iter_t last)
+        {
+            error_code ec;
+            if (!parse(first, last, ec))
+                _SJSON_THROW(ec.to_string());
+            return _root;
+        }
+        json_base &parse(const std::string &x)
+        {
+            return parse(x.begin(), x.end());
         }
-        return as_array()[idx];
-    }
-    const json_base &operator[](size_t idx) const
-    {
-        _ENSURE_IS(json_type::array);
-        return as_array()[idx];
-    }
 
-    // 不使用 char* 以防止 0 被识别成 C 风格字符串
-    template <typename _t>
-    json_base &operator[](const _t *const key)
+        json_base &root() { return _root; }
+        const json_base &root() const { return _root; }
+
+    private:
+        json_base _root;
+        typename parser::buffers _bufs;
+    };
+
+    /*
+    * RFC 6902 JSON Patch
+    * diff 生成将 from 变为 to 的 patch（相同的子树会被直接跳过）
+    * apply_patch 就地修改当前结点；出错时抛出 json_error，此前的操作不会回滚
+    */
+    static json_base diff(const json_base &from, const json_base &to)
     {
-        return this->operator[](std::move(string_t(key)));
+        json_base res = array();
+        string_t path;
+        _diff(res.as_array(), path, from, to);
+        return res;
     }
-    template <typename _t>
-    const json_base &operator[](const _t *const key)const
+    void apply_patch(const json_base &patch)
     {
-        return this->operator[](std::move(string_t(key)));
+        for (const auto &op : patch.as_array())
+            _apply_operation(op);
     }
-
-    json_base &operator[](const string_t &key)
+    // RFC 7386 JSON Merge Patch
+    void merge_patch(const json_base &patch)
     {
-        _ENSURE_IS(json_type::object);
-        if (!is_object())
+        if (!patch.is_object())
         {
-            _type = json_type::object;
-            _data.set(object());
+            *this = patch;
+            return;
         }
-        return as_object()[key];
-    }
-    const json_base &operator[](const string_t &key) const
-    {
-        _ENSURE_IS(json_type::object);
-        static json_base _empty_res;
-        const auto &obj = as_object();
-        const auto &it = obj.find(key);
-        if (it != obj.end())
-            return it->second;
-        return _empty_res;
-    }
-
-    inline json_type type() const { return _type; }
-    std::string type_name()const
-    {
-        if(is_value())
+        if (!is_object())
+            *this = object();
+        auto &obj = as_object();
+        for (const auto &it : patch.as_object())
         {
-            return as_value().type_name();
+            if (it.second._is_null())
+                obj.erase(it.first);
+            else
+                obj[it.first].merge_patch(it.second);
         }
-        else return json_type_name(_type);
     }
-    inline bool is_value() const { return _type == json_type::value; }
-    inline bool is_array() const { return _type == json_type::array; }
-    inline bool is_object() const { return _type == json_type::object; }
 
-    inline array &as_array()
-    {
-        _ENSURE_IS(json_type::array);
-        return _data.as<array>();
-    }
-    inline object &as_object()
+    /*
+    * 深度比较，object 与键的顺序无关，
+    * number_integer 与 number_double 按数值比较
+    */
+    friend bool operator==(const json_base &a, const json_base &b)
     {
-        _ENSURE_IS(json_type::object);
-        return _data.as<object>();
+        return _deep_equal(a, b);
     }
-    inline value &as_value()
+    friend bool operator!=(const json_base &a, const json_base &b)
     {
-        _ENSURE_IS(json_type::value);
-        return _data.as<value>();
+        return !_deep_equal(a, b);
     }
 
-    inline const array &as_array() const
-    {
-        _ENSURE_IS(json_type::array);
-        return _data.as<array>();
-    }
-    inline const object &as_object() const
+    /*
+    * 基于 xxHash64 的结构哈希，与 operator== 一致，结果在不同平台上保持稳定
+    * 结果缓存在结点中，取得可修改的引用或赋值时失效
+    * 注意：通过先前取得的子结点引用修改数据不会使祖先结点的缓存失效
+    */
+    uint64_t hash() const
     {
-        _ENSURE_IS(json_type::object);
-        return _data.as<object>();
-    }
-    inline const value &as_value() const
-    {
-        _ENSURE_IS(json_type::value);
-        return _data.as<value>();
+        uint64_t h = _hash_cache.load(std::memory_order_relaxed);
+        if (h == 0)
+        {
+            h = _compute_hash();
+            if (h == 0)
+                h = 1;
+            _hash_cache.store(h, std::memory_order_relaxed);
+        }
+        return h;
     }
 
-#undef _ENSURE_IS
-
-    bool empty() const
-    {
-        if (is_array())
-            return as_array().empty();
-        if (is_object())
-            return as_object().empty();
-        return _data.empty();
-    }
-    void clear()
-    {
-        if (is_array())
-            as_array().clear();
-        else if (is_object())
-            as_object().clear();
-        else if (is_value())
-            as_value().clear();
-        else
-            _data.clear();
-    }
+private:
+    friend class array;
+    friend class _my_initializer_list;
 
-    inline json_base &at(size_t idx) { return as_array().at(idx); }
-    inline const json_base &at(size_t idx) const { return as_array().at(idx); }
-    inline json_base &at(string_t key) { return as_object().at(key); }
-    inline const json_base &at(string_t key) const { return as_object().at(key); }
+    json_type _type;
+    // value 与 object 直接存放在结点中，array 在堆上分配
+    _fake_union<sizeof(value)> _data;
+    // 缓存的结构哈希，0 表示尚未计算
+    mutable std::atomic<uint64_t> _hash_cache{0};
 
-    std::string dump(const std::string &tab = "  ") const
-    {
-        std::string res;
-        dump(res, tab);
-        return res;
-    }
-    void dump(std::string &dest, const std::string &tab = "  ", int deep = 0) const
+    // 按 dump_options 序列化，缩进由预先生成的缓冲区直接拷贝
+    class _dumper
     {
-        bool need_tab = !tab.empty();
-        auto add_tabs = [&need_tab, &dest, &tab, &deep]()
+    public:
+        _dumper(std::string &dest, const dump_options &opt)
+            : _dest(dest), _opt(opt)
         {
-            if (need_tab)
-                for (int i = 0; i < deep; ++i)
-                    dest += tab;
-        };
-        // 规定如果 deep < 0 则此次不输出（用于 object 的输出）
-        if (deep < 0)
-            deep = -deep;
-        else
-            add_tabs();
+            if (_opt.canonical)
+            {
+                _opt.indent.clear();
+                _opt.space_after_colon = _opt.space_after_comma = false;
+                _opt.sort_keys = true;
+                _opt.ascii_only = false;
+            }
+            _colon = _opt.space_after_colon ? ": " : ":";
+            _comma = (_opt.indent.empty() && _opt.space_after_comma) ? ", " : ",";
+            _newline = "\n";
+        }
 
-        if (is_array())
+        void indent(int deep)
+        {
+            if (!_opt.indent.empty())
+                _dest.append(_indent_buf(deep) + 1, deep * _opt.indent.size());
+        }
+        void newline(int deep)
+        {
+            if (!_opt.indent.empty())
+                _dest.append(_indent_buf(deep), 1 + deep * _opt.indent.size());
+        }
+
+        void write(const json_base &x, int deep)
         {
-            dest += '[';
-            const auto &arr = as_array();
-            if (need_tab && !arr.empty())
-                dest += '\n';
-            for (auto it = arr.begin(); it != arr.end(); ++it)
+            if (x.is_packed())
+                write_packed(x, deep);
+            else if (x.is_array())
             {
-                if (it != arr.begin())
-                    dest += need_tab ? ",\n" : ",";
-                it->dump(dest, tab, deep + 1);
+                const auto &arr = x.as_array();
+                _dest += '[';
+                for (auto it = arr.begin(); it != arr.end(); ++it)
+                {
+                    if (it != arr.begin())
+                        _dest += _comma;
+                    newline(deep + 1);
+                    write(*it, deep + 1);
+                }
+                if (!arr.empty())
+                    newline(deep);
+                _dest += ']';
             }
-            if (need_tab && !arr.empty())
+            else if (x.is_object())
             {
-                dest += '\n';
-                add_tabs();
+                const auto &obj = x.as_object();
+                _dest += '{';
+                if (_opt.sort_keys)
+                {
+                    std::vector<const typename object::value_type *> items;
+                    items.reserve(obj.size());
+                    for (const auto &it : obj)
+                        items.push_back(&it);
+                    std::sort(items.begin(), items.end(),
+                        [](const typename object::value_type *a,
+                           const typename object::value_type *b)
+                        { return _utf16_less(a->first, b->first); });
+                    for (size_t i = 0; i < items.size(); ++i)
+                        write_item(*items[i], i == 0, deep);
+                }
+                else
+                {
+                    for (auto it = obj.begin(); it != obj.end(); ++it)
+                        write_item(*it, it == obj.begin(), deep);
+                }
+                if (!obj.empty())
+                    newline(deep);
+                _dest += '}';
             }
-            dest += ']';
+            else if (x.is_value())
+                write_value(x.as_value());
+            else
+                _dest += "unknown";
         }
-        else if (is_object())
+
+    private:
+        std::string &_dest;
+        dump_options _opt;
+        const char *_colon, *_comma;
+        // "\n" 后接若干层缩进，按需扩展
+        std::string _newline;
+
+        const char *_indent_buf(int deep)
+        {
+            size_t need = 1 + deep * _opt.indent.size();
+            while (_newline.size() < need)
+                _newline += _opt.indent;
+            return _newline.data();
+        }
+
+        // 打包存储的 array：预留空间后在一个循环中格式化全部数值
+        void write_packed(const json_base &x, int deep)
         {
-            dest += '{';
-            const auto &obj = as_object();
-            if (need_tab && !obj.empty())
-                dest += '\n';
-            deep++;
-            for (auto it = obj.begin(); it != obj.end(); ++it)
+            size_t n = x._array_size();
+            bool is_double = x._packed_kind() == value::number_double;
+            _dest.reserve(_dest.size() + n * (is_double ? 25 : 12) + 2);
+            _dest += '[';
+            if (is_double)
             {
-                if (it != obj.begin())
-                    dest += need_tab ? ",\n" : ",";
-                add_tabs();
-                dest += '"';
-                dest += it->first;
-                dest += "\": ";
-                it->second.dump(dest, tab, -deep);
+                const double *p = x._data.template get<_packed_double>().data.data();
+                for (size_t i = 0; i < n; ++i)
+                {
+                    if (i != 0)
+                        _dest += _comma;
+                    newline(deep + 1);
+                    _write_shortest(_dest, p[i], _opt.canonical);
+                }
             }
-            deep--;
-            if (need_tab && !obj.empty())
+            else
             {
-                dest += '\n';
-                add_tabs();
+                const int *p = x._data.template get<_packed_int>().data.data();
+                for (size_t i = 0; i < n; ++i)
+                {
+                    if (i != 0)
+                        _dest += _comma;
+                    newline(deep + 1);
+                    _write_int(_dest, p[i]);
+                }
             }
-            dest += '}';
+            if (n != 0)
+                newline(deep);
+            _dest += ']';
         }
-        else if (is_value())
+
+        void write_item(const typename object::value_type &item, bool first, int deep)
         {
-            bool flag = (as_value().type() == value::string);
-            if (flag)
-                dest += '"';
-            dest += as_value().to_string();
-            if (flag)
-                dest += '"';
+            if (!first)
+                _dest += _comma;
+            newline(deep + 1);
+            write_string(item.first);
+            _dest += _colon;
+            write(item.second, deep + 1);
         }
-        else
+
+        void write_value(const value &v)
         {
-            dest += "unknown";
+            switch (v.type())
+            {
+            case value::string:
+                write_string(v.template as<string_t>());
+                break;
+            case value::number_double:
+                _write_shortest(_dest, v.template as<double>(), _opt.canonical);
+                break;
+            case value::number_integer:
+                _write_int(_dest, v.template as<int>());
+                break;
+            case value::boolean:
+                _dest += v.template as<bool>() ? "true" : "false";
+                break;
+            default:
+                _dest += v.to_string();
+            }
         }
-    }
 
-    class parser
-    {
-    public:
-        enum class node_t
-        {
-            object,
-            object_node,
-            array,
-            value
-        };
-        enum
+        void write_string(const string_t &s)
         {
-            syntax_error,
-            range_error // 数字超出范围
-        };
-        // 返回 true/false 以确定是否保留
-        using filter = std::function<bool(node_t, json_base &)>;
+            static const char hex[] = "0123456789abcdef";
+            _dest += '"';
+            const char *p = s.data(), *e = p + s.size(), *run = p;
+            while (p != e)
+            {
+                unsigned char c = static_cast<unsigned char>(*p);
+                if (c >= 0x20 && c != '"' && c != '\\' && (c < 0x80 || !_opt.ascii_only))
+                {
+                    ++p;
+                    continue;
+                }
+                _dest.append(run, p);
+                if (c >= 0x80)
+                {
+                    unsigned cp = _decode_utf8(p, e);
+                    auto put_u = [this](unsigned u)
+                    {
+                        char buf[6] = {'\\', 'u', hex[(u >> 12) & 0xF], hex[(u >> 8) & 0xF],
+                                       hex[(u >> 4) & 0xF], hex[u & 0xF]};
+                        _dest.append(buf, 6);
+                    };
+                    if (cp >= 0x10000)
+                    {
+                        put_u(0xD800 + ((cp - 0x10000) >> 10));
+                        put_u(0xDC00 + ((cp - 0x10000) & 0x3FF));
+                    }
+                    else
+                        put_u(cp);
+                    run = p;
+                    continue;
+                }
+                switch (c)
+                {
+                case '"': _dest += "\\\""; break;
+                case '\\': _dest += "\\\\"; break;
+                case '\b': _dest += "\\b"; break;
+                case '\f': _dest += "\\f"; break;
+                case '\n': _dest += "\\n"; break;
+                case '\r': _dest += "\\r"; break;
+                case '\t': _dest += "\\t"; break;
+                default:
+                {
+                    char buf[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                    _dest.append(buf, 6);
+                }
+                }
+                run = ++p;
+            }
+            _dest.append(run, e);
+            _dest += '"';
+        }
 
-        // 返回 true/false 以决定是否继续
-        using error_callback_f = std::function<bool(int)>;
+        // 解码 p 处的一个 UTF-8 字符并前移 p，非法序列视为 U+FFFD 且只消耗一个字节
+        static unsigned _decode_utf8(const char *&p, const char *e)
+        {
+            unsigned char c = static_cast<unsigned char>(*p++);
+            int len = c >= 0xF0 ? 3 : (c >= 0xE0 ? 2 : (c >= 0xC0 ? 1 : -1));
+            if (len < 0 || c > 0xF4 || e - p < len)
+                return 0xFFFD;
+            unsigned cp = c & (0x3F >> len);
+            for (int i = 0; i < len; ++i)
+            {
+                unsigned char cc = static_cast<unsigned char>(p[i]);
+                if ((cc & 0xC0) != 0x80)
+                    return 0xFFFD;
+                cp = (cp << 6) | (cc & 0x3F);
+            }
+            static const unsigned min_cp[] = {0, 0x80, 0x800, 0x10000};
+            if (cp < min_cp[len] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+                return 0xFFFD;
+            p += len;
+            return cp;
+        }
 
-        template <typename _iter_t>
-        static void parse(
-            json_base &res, _iter_t first, _iter_t last)
+        /*
+        * 按 UTF-16 码元比较两个 UTF-8 字符串（RFC 8785 的键排序规则）
+        * 只有 U+E000~U+FFFF 与辅助平面字符的先后与字节序不同
+        */
+        static bool _utf16_less(const string_t &a, const string_t &b)
         {
-            using token = std::pair<_iter_t, _iter_t>;
+            size_t n = std::min(a.size(), b.size()), i = 0;
+            while (i < n && a[i] == b[i])
+                ++i;
+            if (i == n)
+                return a.size() < b.size();
+            unsigned char x = static_cast<unsigned char>(a[i]);
+            unsigned char y = static_cast<unsigned char>(b[i]);
+            bool x_high = x >= 0xF0, y_high = y >= 0xF0;
+            bool x_bmp_top = x == 0xEE || x == 0xEF, y_bmp_top = y == 0xEE || y == 0xEF;
+            if (x_high && y_bmp_top)
+                return true;
+            if (x_bmp_top && y_high)
+                return false;
+            return x < y;
+        }
 
-            auto it = first;
-            auto skip_blank = [&it, &last]()
+        /*
+        * ECMAScript Number::toString 的格式，使用可往返的最短有效位数
+        * 非规范化输出时保留 ".0" 以便解析后仍为 number_double，NaN 与 Infinity 输出为 null
+        */
+        static void _write_shortest(std::string &dest, double x, bool canonical)
+        {
+            if (!std::isfinite(x))
             {
-                while (it != last && isspace(*it))
-                    ++it;
-            };
-            skip_blank();
-            //first
+                if (canonical)
+                    _SJSON_THROW("NaN and Infinity are not allowed in canonical JSON");
+                dest += "null";
+                return;
+            }
+            if (x == 0)
+            {
+                dest += canonical ? "0" : (std::signbit(x) ? "-0.0" : "0.0");
+                return;
+            }
+            /*
+            * 若 15 位有效数字可以往返，则去掉末尾的 0 即为最短表示
+            * （更短的表示按 15 位舍入后必然与之相同），否则再尝试 16、17 位
+            * 非规格化数的精度不足 15 位，需要从 1 位开始逐个尝试
+            */
+            char buf[32];
+            for (int prec = std::fabs(x) < DBL_MIN ? 1 : 15; prec <= 17; ++prec)
+            {
+                snprintf(buf, sizeof(buf), "%.*e", prec - 1, x);
+                if (strtod(buf, nullptr) == x)
+                    break;
+            }
+            const char *p = buf;
+            if (*p == '-')
+                dest += *p++;
+            char digits[20];
+            int k = 0;
+            for (; *p != 'e'; ++p)
+                if (*p != '.')
+                    digits[k++] = *p;
+            while (k > 1 && digits[k - 1] == '0')
+                --k;
+            int n = atoi(p + 1) + 1;
+            if (k <= n && n <= 21)
+            {
+                dest.append(digits, k);
+                dest.append(n - k, '0');
+                if (!canonical)
+                    dest += ".0";
+            }
+            else if (0 < n && n <= 21)
+            {
+                dest.append(digits, n);
+                dest += '.';
+                dest.append(digits + n, k - n);
+            }
+            else if (-6 < n && n <= 0)
+            {
+                dest += "0.";
+                dest.append(-n, '0');
+                dest.append(digits, k);
+            }
+            else
+            {
+                dest += digits[0];
+                if (k > 1)
+                {
+                    dest += '.';
+                    dest.append(digits + 1, k - 1);
+                }
+                dest += 'e';
+                dest += n - 1 < 0 ? '-' : '+';
+                _write_int(dest, n - 1 < 0 ? 1 - n : n - 1);
+            }
+        }
+        static void _write_int(std::string &dest, int x)
+        {
+            char buf[12], *p = buf + sizeof(buf);
+            // 用 unsigned 处理 INT_MIN
+            unsigned u = x < 0 ? 0u - unsigned(x) : unsigned(x);
+            do
+                *--p = char('0' + u % 10);
+            while (u /= 10);
+            if (x < 0)
+                *--p = '-';
+            dest.append(p, buf + sizeof(buf) - p);
         }
     };
 
-    template <typename _iter_t>
-    static json_base parse(_iter_t first, _iter_t last)
-    {
-        json_base res;
-        parser::parse(res, first, last);
-        return res;
-    }
-    static json_base parse(const std::string &x)
-    {
-        return parse(x.begin(), x.end());
-    }
-
-private:
-    friend class array;
-    friend class _my_initializer_list;
-
-    json_type _type;
-    _fake_union _data;
-
     class _my_initializer_list
     {
     public:
@@ -779,12 +3113,16 @@ private:
     {
         _type = x._type;
         _data = x._data;
+        _hash_cache.store(
+            x._hash_cache.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
     }
     template <typename _t, json_type _t_val>
     void _assign(const _t &x)
     {
-        if (_type == _t_val)
-            _data.as<_t>() = x;
+        _invalidate_hash();
+        if (_type == _t_val && _data.template holds<_t>())
+            _data.template get<_t>() = x;
         else
         {
             _data.set(x);
@@ -804,6 +3142,640 @@ private:
         _assign<object, json_type::object>(x);
     }
 
+    // 解析时复用结点中原有的字符串以保留其容量
+    string_t &_reuse_string()
+    {
+        if (!is_value() || as_value().type() != value::string)
+            _assign(value(string_t()));
+        auto &s = as_value().template as<string_t>();
+        s.clear();
+        return s;
+    }
+
+    inline void _invalidate_hash()
+    {
+        _hash_cache.store(0, std::memory_order_relaxed);
+    }
+
+    // number_integer 与 number_double 按数值统一哈希，0.0 与 -0.0 视为相同
+    static inline uint64_t _hash_number(double d)
+    {
+        if (d == 0)
+            d = 0;
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(bits));
+        return _xxh64_mix(_hash_seed_number, bits);
+    }
+    static uint64_t _hash_value(const value &v)
+    {
+        switch (v.type())
+        {
+        case value::number_integer:
+        case value::number_double:
+            return _hash_number(_number_of(v));
+        case value::string:
+        {
+            const auto &s = v.template as<string_t>();
+            return _xxh64(s.data(), s.size(), _hash_seed_string);
+        }
+        case value::boolean:
+            return _xxh64_mix(_hash_seed_boolean, v.template as<bool>());
+        }
+        return _xxh64_mix(_hash_seed_null, 0);
+    }
+    uint64_t _compute_hash() const
+    {
+        if (is_packed())
+        {
+            uint64_t h = _hash_seed_array;
+            size_t n = _array_size();
+            double x = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                _number_at(i, x);
+                h = _xxh64_merge(h, _hash_number(x));
+            }
+            return _xxh64_mix(h, n);
+        }
+        if (is_array())
+        {
+            const auto &arr = _data.template get<array>();
+            uint64_t h = _hash_seed_array;
+            for (const auto &it : arr)
+                h = _xxh64_merge(h, it.hash());
+            return _xxh64_mix(h, arr.size());
+        }
+        if (is_object())
+        {
+            // 对各成员的哈希求和，使结果与键的顺序无关
+            uint64_t sum = 0;
+            for (const auto &it : as_object())
+                sum += _xxh64_merge(
+                    _xxh64(it.first.data(), it.first.size(), _hash_seed_string),
+                    it.second.hash());
+            return _xxh64_mix(_xxh64_merge(_hash_seed_object, sum), as_object().size());
+        }
+        return _hash_value(as_value());
+    }
+
+    inline const value *_value_ptr() const
+    {
+        return (is_value() && !_data.empty()) ? &_data.template get<value>() : nullptr;
+    }
+    result<double> _try_get(double *) const
+    {
+        const value *v = _value_ptr();
+        if (v != nullptr && v->type() == value::number_double)
+            return result<double>::_ok(v->_data.template get<double>());
+        if (v != nullptr && v->type() == value::number_integer)
+            return result<double>::_ok(v->_data.template get<int>());
+        return result<double>::_fail(parser::type_error);
+    }
+    result<int> _try_get(int *) const
+    {
+        const value *v = _value_ptr();
+        if (v != nullptr && v->type() == value::number_integer)
+            return result<int>::_ok(v->_data.template get<int>());
+        return result<int>::_fail(parser::type_error);
+    }
+    result<bool> _try_get(bool *) const
+    {
+        const value *v = _value_ptr();
+        if (v != nullptr && v->type() == value::boolean)
+            return result<bool>::_ok(v->_data.template get<bool>());
+        return result<bool>::_fail(parser::type_error);
+    }
+    result<string_t> _try_get(string_t *) const
+    {
+        const value *v = _value_ptr();
+        if (v != nullptr && v->type() == value::string)
+            return result<string_t>::_ok(&v->_data.template get<string_t>());
+        return result<string_t>::_fail(parser::type_error);
+    }
+    result<array> _try_get(array *) const
+    {
+        if (is_array())
+            return result<array>::_ok(&as_array());
+        return result<array>::_fail(parser::type_error);
+    }
+    result<object> _try_get(object *) const
+    {
+        if (is_object())
+            return result<object>::_ok(&_data.template get<object>());
+        return result<object>::_fail(parser::type_error);
+    }
+
+    // 打包存储的数据，mirror 为 const 访问以结点方式读取时才创建的只读副本
+    template <typename _t>
+    struct _packed
+    {
+        std::vector<_t> data;
+        mutable std::atomic<array *> mirror{nullptr};
+
+        explicit _packed(std::vector<_t> &&x) : data(std::move(x)) {}
+        _packed(const _packed &x) : data(x.data) {}
+        _packed(_packed &&x) noexcept
+            : data(std::move(x.data)), mirror(x.mirror.exchange(nullptr)) {}
+        _packed &operator=(const _packed &) = delete;
+        ~_packed() { delete mirror.load(std::memory_order_relaxed); }
+
+        // 修改 data 后调用
+        void changed() { delete mirror.exchange(nullptr); }
+    };
+    using _packed_double = _packed<double>;
+    using _packed_int = _packed<int>;
+
+    // 打包存储的元素类型，未打包时为 value::null
+    inline int _packed_kind() const
+    {
+        if (_type != json_type::array || _data.template holds<array>())
+            return value::null;
+        if (_data.template holds<_packed_double>())
+            return value::number_double;
+        if (_data.template holds<_packed_int>())
+            return value::number_integer;
+        return value::null;
+    }
+    inline size_t _array_size() const
+    {
+        switch (_packed_kind())
+        {
+        case value::number_double:
+            return _data.template get<_packed_double>().data.size();
+        case value::number_integer:
+            return _data.template get<_packed_int>().data.size();
+        }
+        return _data.template as<array>().size();
+    }
+    // 取第 idx 个元素的数值，不是数字时返回 false
+    bool _number_at(size_t idx, double &res) const
+    {
+        switch (_packed_kind())
+        {
+        case value::number_double:
+            res = _data.template get<_packed_double>().data[idx];
+            return true;
+        case value::number_integer:
+            res = _data.template get<_packed_int>().data[idx];
+            return true;
+        }
+        const value *v = _data.template get<array>()[idx]._value_ptr();
+        if (v == nullptr ||
+            (v->type() != value::number_double && v->type() != value::number_integer))
+            return false;
+        res = _number_of(*v);
+        return true;
+    }
+
+    // 多个线程同时首次访问时各自创建，只保留其中一个
+    const array &_packed_mirror() const
+    {
+        bool is_double = _packed_kind() == value::number_double;
+        auto &slot = is_double ? _data.template get<_packed_double>().mirror
+                               : _data.template get<_packed_int>().mirror;
+        array *res = slot.load(std::memory_order_acquire);
+        if (res != nullptr)
+            return *res;
+        array *created = new array(
+            is_double ? _unpacked(_data.template get<_packed_double>().data)
+                      : _unpacked(_data.template get<_packed_int>().data));
+        if (slot.compare_exchange_strong(res, created, std::memory_order_acq_rel))
+            return *created;
+        delete created;
+        return *res;
+    }
+    // 只转换当前结点
+    void _unpack_self()
+    {
+        switch (_packed_kind())
+        {
+        case value::number_double:
+            _data.set(_unpacked(_data.template get<_packed_double>().data));
+            break;
+        case value::number_integer:
+            _data.set(_unpacked(_data.template get<_packed_int>().data));
+            break;
+        }
+    }
+    // 元素与打包的类型相同时直接修改，返回是否成功
+    bool _packed_push_back(const json_base &x)
+    {
+        const value *v = x._value_ptr();
+        int kind = _packed_kind();
+        if (v == nullptr || kind == value::null || v->type() != kind)
+            return false;
+        if (kind == value::number_double)
+        {
+            _data.template get<_packed_double>().data.push_back(v->_data.template get<double>());
+            _data.template get<_packed_double>().changed();
+        }
+        else
+        {
+            _data.template get<_packed_int>().data.push_back(v->_data.template get<int>());
+            _data.template get<_packed_int>().changed();
+        }
+        return true;
+    }
+    bool _packed_set(size_t idx, const json_base &x)
+    {
+        const value *v = x._value_ptr();
+        int kind = _packed_kind();
+        if (v == nullptr || kind == value::null || v->type() != kind)
+            return false;
+        if (kind == value::number_double)
+        {
+            _data.template get<_packed_double>().data[idx] = v->_data.template get<double>();
+            _data.template get<_packed_double>().changed();
+        }
+        else
+        {
+            _data.template get<_packed_int>().data[idx] = v->_data.template get<int>();
+            _data.template get<_packed_int>().changed();
+        }
+        return true;
+    }
+    template <typename _t>
+    static array _unpacked(const std::vector<_t> &x)
+    {
+        array res;
+        res.reserve(x.size());
+        for (auto it : x)
+            res.emplace_back(value(it));
+        return res;
+    }
+    // 只检查当前结点，子结点由调用者负责
+    void _pack_self()
+    {
+        if (!is_array() || !_data.template holds<array>())
+            return;
+        const auto &arr = _data.template get<array>();
+        if (arr.empty())
+            return;
+        const value *first = arr[0]._value_ptr();
+        int kind = first ? first->type() : value::null;
+        if (kind != value::number_double && kind != value::number_integer)
+            return;
+        for (const auto &it : arr)
+        {
+            const value *v = it._value_ptr();
+            if (v == nullptr || v->type() != kind)
+                return;
+        }
+        if (kind == value::number_double)
+            _data.set(_packed_double(_packed_from<double>(arr)));
+        else
+            _data.set(_packed_int(_packed_from<int>(arr)));
+    }
+    template <typename _t>
+    static std::vector<_t> _packed_from(const array &arr)
+    {
+        std::vector<_t> res;
+        res.reserve(arr.size());
+        for (const auto &it : arr)
+            res.push_back(it._value_ptr()->_data.template get<_t>());
+        return res;
+    }
+
+    bool _copy_packed(std::vector<double> &dest) const
+    {
+        if (_packed_kind() == value::number_double)
+        {
+            const auto &x = _data.template get<_packed_double>().data;
+            dest.assign(x.begin(), x.end());
+        }
+        else
+        {
+            const auto &x = _data.template get<_packed_int>().data;
+            dest.assign(x.begin(), x.end());
+        }
+        return true;
+    }
+    bool _copy_packed(std::vector<int> &dest) const
+    {
+        if (_packed_kind() != value::number_integer)
+            return false;
+        const auto &x = _data.template get<_packed_int>().data;
+        dest.assign(x.begin(), x.end());
+        return true;
+    }
+    template <typename _t>
+    bool _copy_packed(std::vector<_t> &) const
+    {
+        return false;
+    }
+
+    inline bool _is_null() const
+    {
+        return is_value() && as_value().type() == value::null;
+    }
+
+    static bool _deep_equal(const json_base &a, const json_base &b)
+    {
+        if (&a == &b)
+            return true;
+        if (a._type != b._type)
+            return false;
+        if (a.is_packed() || b.is_packed())
+        {
+            size_t n = a._array_size();
+            if (n != b._array_size())
+                return false;
+            double x = 0, y = 0;
+            for (size_t i = 0; i < n; ++i)
+                if (!a._number_at(i, x) || !b._number_at(i, y) || x != y)
+                    return false;
+            return true;
+        }
+        if (a.is_array())
+        {
+            const auto &x = a.as_array(), &y = b.as_array();
+            if (x.size() != y.size())
+                return false;
+            for (size_t i = 0; i < x.size(); ++i)
+                if (!_deep_equal(x[i], y[i]))
+                    return false;
+            return true;
+        }
+        if (a.is_object())
+        {
+            const auto &x = a.as_object(), &y = b.as_object();
+            if (x.size() != y.size())
+                return false;
+            for (const auto &it : x)
+            {
+                auto f = y.find(it.first);
+                if (f == y.end() || !_deep_equal(it.second, f->second))
+                    return false;
+            }
+            return true;
+        }
+        const auto &x = a.as_value(), &y = b.as_value();
+        // number_integer 与 number_double 按数值比较
+        bool x_num = x.type() == value::number_integer || x.type() == value::number_double;
+        bool y_num = y.type() == value::number_integer || y.type() == value::number_double;
+        if (x_num && y_num)
+        {
+            if (x.type() == value::number_integer && y.type() == value::number_integer)
+                return x.template as<int>() == y.template as<int>();
+            return _number_of(x) == _number_of(y);
+        }
+        if (x.type() != y.type())
+            return false;
+        switch (x.type())
+        {
+        case value::string:
+            return x.template as<string_t>() == y.template as<string_t>();
+        case value::boolean:
+            return x.template as<bool>() == y.template as<bool>();
+        }
+        return true;
+    }
+    static inline double _number_of(const value &v)
+    {
+        return v.type() == value::number_integer
+                   ? v.template as<int>()
+                   : v.template as<double>();
+    }
+
+    // JSON Pointer 中 '~' 与 '/' 需要转义为 "~0" 与 "~1"
+    static void _append_pointer_token(string_t &path, const string_t &token)
+    {
+        path += '/';
+        for (char c : token)
+        {
+            if (c == '~')
+                path += "~0";
+            else if (c == '/')
+                path += "~1";
+            else
+                path += c;
+        }
+    }
+    static std::vector<string_t> _split_pointer(const string_t &ptr)
+    {
+        std::vector<string_t> res;
+        if (ptr.empty())
+            return res;
+        if (ptr[0] != '/')
+            _SJSON_THROW("invalid json pointer: " + ptr);
+        for (size_t i = 0; i < ptr.size(); ++i)
+        {
+            char c = ptr[i];
+            if (c == '/')
+                res.emplace_back();
+            else if (c != '~')
+                res.back() += c;
+            else if (i + 1 < ptr.size() && (ptr[i + 1] == '0' || ptr[i + 1] == '1'))
+                res.back() += ptr[++i] == '0' ? '~' : '/';
+            else
+                _SJSON_THROW("invalid json pointer: " + ptr);
+        }
+        return res;
+    }
+    // 解析数组下标，"-" 表示末尾之后的位置
+    static size_t _pointer_index(const string_t &token, size_t size, bool allow_end)
+    {
+        if (allow_end && token == "-")
+            return size;
+        if (token.empty() || token.size() > 18 ||
+            (token.size() > 1 && token[0] == '0') ||
+            token.find_first_not_of("0123456789") != string_t::npos)
+            _SJSON_THROW("invalid array index: " + token);
+        size_t idx = std::stoull(token);
+        if (idx > size || (idx == size && !allow_end))
+            _SJSON_THROW("array index out of range: " + token);
+        return idx;
+    }
+    json_base &_resolve_pointer(
+        const std::vector<string_t> &tokens, size_t count)
+    {
+        json_base *cur = this;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (cur->is_object())
+            {
+                auto &obj = cur->as_object();
+                auto it = obj.find(tokens[i]);
+                if (it == obj.end())
+                    _SJSON_THROW("json pointer refers to a missing key: " + tokens[i]);
+                cur = &it->second;
+            }
+            else if (cur->is_array())
+            {
+                auto &arr = cur->as_array();
+                cur = &arr[_pointer_index(tokens[i], arr.size(), false)];
+            }
+            else
+                _SJSON_THROW("json pointer goes through a value: " + tokens[i]);
+        }
+        return *cur;
+    }
+
+    static void _push_operation(
+        array &patch, const char *op, const string_t &path, const json_base *val)
+    {
+        json_base x = object();
+        auto &obj = x.as_object();
+        obj["op"] = op;
+        obj["path"] = path;
+        if (val != nullptr)
+            obj["value"] = *val;
+        patch.push_back(x);
+    }
+    static void _diff(
+        array &patch, string_t &path, const json_base &a, const json_base &b)
+    {
+        if (_deep_equal(a, b))
+            return;
+        if (a._type != b._type || a.is_value())
+        {
+            _push_operation(patch, "replace", path, &b);
+            return;
+        }
+        size_t path_len = path.size();
+        if (a.is_object())
+        {
+            const auto &x = a.as_object(), &y = b.as_object();
+            for (const auto &it : x)
+            {
+                _append_pointer_token(path, it.first);
+                auto f = y.find(it.first);
+                if (f == y.end())
+                    _push_operation(patch, "remove", path, nullptr);
+                else
+                    _diff(patch, path, it.second, f->second);
+                path.resize(path_len);
+            }
+            for (const auto &it : y)
+            {
+                if (x.find(it.first) != x.end())
+                    continue;
+                _append_pointer_token(path, it.first);
+                _push_operation(patch, "add", path, &it.second);
+                path.resize(path_len);
+            }
+            return;
+        }
+        if (a.is_packed() || b.is_packed())
+        {
+            // 打包的 array 没有结点，比较转换后的副本
+            json_base x = a, y = b;
+            x._unpack_self();
+            y._unpack_self();
+            _diff(patch, path, x, y);
+            return;
+        }
+        // 去掉相同的前后缀后逐个比较，多余的部分再删除或添加
+        const auto &x = a.as_array(), &y = b.as_array();
+        size_t pre = 0, suf = 0;
+        while (pre < x.size() && pre < y.size() && _deep_equal(x[pre], y[pre]))
+            ++pre;
+        while (suf < x.size() - pre && suf < y.size() - pre &&
+               _deep_equal(x[x.size() - 1 - suf], y[y.size() - 1 - suf]))
+            ++suf;
+        size_t len_x = x.size() - pre - suf, len_y = y.size() - pre - suf;
+        size_t common = std::min(len_x, len_y);
+        for (size_t i = 0; i < common; ++i)
+        {
+            _append_pointer_token(path, std::to_string(pre + i));
+            _diff(patch, path, x[pre + i], y[pre + i]);
+            path.resize(path_len);
+        }
+        _append_pointer_token(path, std::to_string(pre + common));
+        for (size_t i = common; i < len_x; ++i)
+            _push_operation(patch, "remove", path, nullptr);
+        path.resize(path_len);
+        for (size_t i = common; i < len_y; ++i)
+        {
+            _append_pointer_token(path, std::to_string(pre + i));
+            _push_operation(patch, "add", path, &y[pre + i]);
+            path.resize(path_len);
+        }
+    }
+
+    void _patch_add(const std::vector<string_t> &tokens, const json_base &val)
+    {
+        if (tokens.empty())
+        {
+            *this = val;
+            return;
+        }
+        auto &parent = _resolve_pointer(tokens, tokens.size() - 1);
+        if (parent.is_object())
+            parent.as_object()[tokens.back()] = val;
+        else if (parent.is_array())
+        {
+            auto &arr = parent.as_array();
+            size_t idx = _pointer_index(tokens.back(), arr.size(), true);
+            arr.insert(arr.begin() + idx, val);
+        }
+        else
+            _SJSON_THROW("cannot add a member to a value");
+    }
+    void _patch_remove(const std::vector<string_t> &tokens)
+    {
+        if (tokens.empty())
+            _SJSON_THROW("cannot remove the root");
+        auto &parent = _resolve_pointer(tokens, tokens.size() - 1);
+        if (parent.is_object())
+        {
+            if (parent.as_object().erase(tokens.back()) == 0)
+                _SJSON_THROW("json pointer refers to a missing key: " + tokens.back());
+        }
+        else if (parent.is_array())
+        {
+            auto &arr = parent.as_array();
+            arr.erase(arr.begin() + _pointer_index(tokens.back(), arr.size(), false));
+        }
+        else
+            _SJSON_THROW("cannot remove a member from a value");
+    }
+    void _apply_operation(const json_base &op)
+    {
+        const auto &obj = op.as_object();
+        auto member = [&obj](const char *name) -> const json_base &
+        {
+            auto it = obj.find(name);
+            if (it == obj.end())
+                _SJSON_THROW(std::string("patch operation lacks \"") + name + '"');
+            return it->second;
+        };
+        const string_t &name = member("op").as_value().template as<string_t>();
+        auto path = _split_pointer(member("path").as_value().template as<string_t>());
+
+        if (name == "add")
+            _patch_add(path, member("value"));
+        else if (name == "remove")
+            _patch_remove(path);
+        else if (name == "replace")
+            _resolve_pointer(path, path.size()) = member("value");
+        else if (name == "move" || name == "copy")
+        {
+            const string_t &from_str = member("from").as_value().template as<string_t>();
+            auto from = _split_pointer(from_str);
+            if (name == "move")
+            {
+                const string_t &path_str = member("path").as_value().template as<string_t>();
+                if (path_str == from_str)
+                    return;
+                if (path_str.compare(0, from_str.size(), from_str) == 0 &&
+                    path_str[from_str.size()] == '/')
+                    _SJSON_THROW("cannot move a value into one of its children");
+            }
+            json_base val = _resolve_pointer(from, from.size());
+            if (name == "move")
+                _patch_remove(from);
+            _patch_add(path, val);
+        }
+        else if (name == "test")
+        {
+            if (!_deep_equal(_resolve_pointer(path, path.size()), member("value")))
+                _SJSON_THROW("test operation failed");
+        }
+        else
+            _SJSON_THROW("unknown patch operation: " + name);
+    }
+
     inline void _ensure_is(json_type x) const
     {
         if (_type != x)
@@ -816,9 +3788,64 @@ private:
 };
 
 using json = json_base<void>;
-json operator""_json(const char *s)
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+template <size_t N>
+struct _literal_string
+{
+    char data[N];
+    constexpr _literal_string(const char (&s)[N])
+    {
+        for (size_t i = 0; i < N; ++i)
+            data[i] = s[i];
+    }
+};
+/*
+* C++20 起 "..."_json 在编译期校验，
+* 每个字面量只在第一次使用时解析一次，之后返回其副本
+*/
+template <_literal_string s>
+inline json operator""_json()
+{
+    static_assert(_literal_checker{s.data, sizeof(s.data) - 1}.valid(), "malformed json literal");
+    static const json res = json::parse(s.data, s.data + sizeof(s.data) - 1);
+    return res;
+}
+#else
+inline json operator""_json(const char *s, size_t n)
 {
-    return json::parse(s);
+    return json::parse(s, s + n);
+}
+#endif
+
 }
 
+/*
+* SJSON_LITERAL("...") 返回字面量解析结果的 const 引用
+* C++14 起在编译期校验，每个使用处只在第一次执行时解析一次
+*/
+#if _HASCPP14
+#define _SJSON_LITERAL_CHECK(s) \
+    static_assert(::sjson::_literal_checker{s, sizeof(s) - 1}.valid(), "malformed json literal: " s)
+#else
+#define _SJSON_LITERAL_CHECK(s) static_assert(sizeof(s) > 0, "")
+#endif
+#define SJSON_LITERAL(s)                                                      \
+    ([]() -> const ::sjson::json & {                                          \
+        _SJSON_LITERAL_CHECK(s);                                              \
+        static const ::sjson::json _sjson_literal =                           \
+            ::sjson::json::parse(s, s + sizeof(s) - 1);                       \
+        return _sjson_literal;                                                \
+    }())
+
+namespace std
+{
+template <typename T>
+struct hash<sjson::json_base<T>>
+{
+    size_t operator()(const sjson::json_base<T> &x) const
+    {
+        return static_cast<size_t>(x.hash());
+    }
+};
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+/*
+* 替换全局 operator new 统计堆分配次数
+* 定义的是替换函数而不是 inline 函数，每个程序只能在一个源文件中包含
+*/
+#include <cstdlib>
+#include <new>
+
+static size_t allocations = 0;
+
+void *operator new(size_t n)
+{
+    ++allocations;
+    void *p = malloc(n ? n : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
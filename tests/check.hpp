@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdio>
+
+static int failures = 0;
+
+// 失败时记录并继续，main 最后以 failures 作为返回值
+#define CHECK(expr)                                              \
+    do                                                           \
+    {                                                            \
+        if (!(expr))                                             \
+        {                                                        \
+            ++failures;                                          \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #expr); \
+        }                                                        \
+    } while (0)
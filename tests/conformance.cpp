@@ -0,0 +1,85 @@
+/*
+* 一致性测试：按文件名前缀检查 corpus 中每个文件的解析结果
+* 接受的文件还要求各种输出选项下 dump -> parse 得到相同的值
+*/
+#include "sjson/sjson.hpp"
+#include "corpus_util.hpp"
+#include <cstdio>
+
+using namespace sjson;
+
+static int failures = 0;
+
+static void report(const char *path, const std::string &what)
+{
+    ++failures;
+    printf("FAIL %s: %s\n", path, what.c_str());
+}
+
+static void check_roundtrip(const char *path, const json &x, const json::dump_options &opt)
+{
+    json::error_code ec;
+    json y = json::parse(x.dump(opt), ec);
+    if (ec)
+        report(path, "dump output rejected: " + ec.to_string());
+    else if (y != x)
+        report(path, "dump -> parse changed the value");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: %s corpus-files...\n", argv[0]);
+        return 1;
+    }
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *path = argv[i];
+        std::string text;
+        if (!read_file(path, text))
+        {
+            report(path, "cannot open");
+            continue;
+        }
+        char kind = expected_kind(path);
+
+        json::error_code ec;
+        json x = json::parse(text, ec);
+        if (kind == 'y' && ec)
+            report(path, "rejected: " + ec.to_string());
+        else if (kind == 'n' && !ec)
+            report(path, "accepted");
+
+        // 抛出异常的接口应当给出相同的结论
+        bool threw = false;
+        try
+        {
+            json::parse(text);
+        }
+        catch (const json_error &)
+        {
+            threw = true;
+        }
+        if (threw != bool(ec))
+            report(path, "throwing and non-throwing parse disagree");
+
+        if (ec)
+            continue;
+        json::dump_options opt;
+        check_roundtrip(path, x, opt);
+        opt.indent.clear();
+        check_roundtrip(path, x, opt);
+        json::dump_options canonical;
+        canonical.canonical = true;
+        check_roundtrip(path, x, canonical);
+        if (kind == 'y')
+        {
+            json::dump_options ascii;
+            ascii.ascii_only = true;
+            check_roundtrip(path, x, ascii);
+        }
+    }
+    printf("%d files, %d failures\n", argc - 1, failures);
+    return failures != 0;
+}
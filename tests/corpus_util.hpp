@@ -0,0 +1,20 @@
+#pragma once
+#include <fstream>
+#include <iterator>
+#include <string>
+
+inline bool read_file(const char *path, std::string &dest)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    dest.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// 文件名的第一个字符：y 必须接受，n 必须拒绝，i 由实现决定
+inline char expected_kind(const std::string &path)
+{
+    size_t pos = path.find_last_of("/\\");
+    return path[pos == std::string::npos ? 0 : pos + 1];
+}
@@ -0,0 +1,74 @@
+/*
+* json::document 的复用：结构相同的消息在稳定后解析不再分配内存，
+* 且结果与重新解析的结果相同
+*/
+#include "sjson/sjson.hpp"
+#include "alloc_counter.hpp"
+#include "check.hpp"
+#include <string>
+#include <vector>
+
+using namespace sjson;
+
+// 键与数组长度相同，数值与字符串内容（包括超出短字符串缓冲区的长度）各不相同
+static std::string message(int i)
+{
+    std::string s = "{\"id\": " + std::to_string(i) +
+                    ", \"user\": \"user-name-that-does-not-fit-inline-" + std::to_string(i % 7) +
+                    "\", \"price\": 0.1000000000000000" + std::to_string(i % 9 + 1) +
+                    ", \"tags\": [\"alpha-long-tag-value\", \"b\", \"c\"]" +
+                    ", \"nested\": {\"ok\": " + (i % 2 ? "true" : "false") + ", \"items\": [";
+    for (int k = 0; k < 10; ++k)
+        s += (k ? ", " : "") + std::string("{\"k\": ") + std::to_string(k * i) +
+             ", \"v\": \"value-string-longer-than-sso\"}";
+    return s + "]}}";
+}
+
+int main()
+{
+    std::vector<std::string> messages;
+    for (int i = 0; i < 200; ++i)
+        messages.push_back(message(i));
+
+    json::document doc;
+    json::error_code ec;
+    for (const auto &m : messages)
+    {
+        CHECK(doc.parse(m, ec));
+        CHECK(doc.root() == json::parse(m));
+    }
+
+    size_t before = allocations;
+    for (int round = 0; round < 3; ++round)
+        for (const auto &m : messages)
+            doc.parse(m, ec);
+    size_t steady = allocations - before;
+    CHECK(steady == 0);
+
+    before = allocations;
+    for (const auto &m : messages)
+        json::parse(m);
+    size_t fresh = allocations - before;
+    CHECK(fresh > 0);
+    printf("steady-state allocations: %zu, fresh parse: %.1f per message\n",
+           steady, double(fresh) / messages.size());
+
+    // 结构变化时结果仍与重新解析的相同
+    const char *sequence[] = {
+        "[1, 2, 3]", "{\"a\": 1}", "\"str\"",
+        "{\"a\": {\"b\": [1, {\"c\": 2}]}, \"d\": 3}",
+        "{\"d\": 3, \"a\": {\"b\": [{\"c\": 2}], \"x\": null}}",
+        "{}", "[]", "{\"a\": 1, \"a\": 2}", "[\"x\", [], {}]", "[{\"q\": 1}, \"s\", 5]"};
+    for (const char *s : sequence)
+    {
+        CHECK(doc.parse(std::string(s), ec));
+        CHECK(doc.root() == json::parse(std::string(s)));
+    }
+
+    // 出错后仍可继续使用
+    CHECK(!doc.parse(std::string("[1, "), ec));
+    CHECK(doc.parse(std::string("[1, 2]"), ec) && doc.root() == json::parse(std::string("[1, 2]")));
+
+    printf("%d failures\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,87 @@
+/*
+* 打包存储的 array：const 访问不改变存储，修改时只在类型不同时才转换回结点
+*/
+#include "sjson/sjson.hpp"
+#include "check.hpp"
+
+using namespace sjson;
+
+int main()
+{
+    json j = {1.5, 2.5, 3.5};
+    j.pack();
+    CHECK(j.is_packed());
+
+    // 视图在 const 访问之后仍然有效
+    auto view = j.values<double>();
+    const json &cj = j;
+    CHECK(cj[1].try_get<double>().value_or(0) == 2.5);
+    CHECK(cj.at(2).try_get<double>().value_or(0) == 3.5);
+    CHECK(cj.as_array().size() == 3);
+    CHECK(cj.find(0)->try_get<double>().value_or(0) == 1.5);
+    CHECK(cj.try_get<json::array>()->size() == 3);
+    double node_sum = 0;
+    for (const auto &e : cj.as_array())
+        node_sum += e.try_get<double>().value_or(0);
+    CHECK(node_sum == 7.5);
+    CHECK(j.is_packed());
+    double sum = 0;
+    for (double x : view)
+        sum += x;
+    CHECK(sum == 7.5);
+
+    // 修改后只读副本随之更新
+    j.set(1, 9.5);
+    CHECK(cj[1].try_get<double>().value_or(0) == 9.5);
+    j.set(1, 2.5);
+
+    // 非 const 的结点访问先转换回普通的 array
+    json n = j;
+    CHECK(n[0].try_get<double>().value_or(0) == 1.5);
+    CHECK(!n.is_packed());
+    CHECK(n == j);
+
+    // 相同类型的修改保持打包
+    uint64_t h = j.hash();
+    j.push_back(4.5);
+    j.set(0, 0.5);
+    CHECK(j.is_packed());
+    CHECK(j.hash() != h);
+    CHECK(j == json::parse("[0.5, 2.5, 3.5, 4.5]"));
+    CHECK(j.hash() == json::parse("[0.5, 2.5, 3.5, 4.5]").hash());
+
+    // 类型不同时转换回普通的 array
+    j.push_back(7);
+    CHECK(!j.is_packed());
+    CHECK(j[4].try_get<int>().value_or(0) == 7);
+
+    json k = {1, 2, 3};
+    k.pack();
+    k.set(1, "x");
+    CHECK(!k.is_packed());
+    CHECK(k.dump("") == R"([1,"x",3])");
+
+    // const 对象上的只读操作
+    const json c = [] { json x = {{"v", {1, 2, 3}}}; x.pack(); return x; }();
+    CHECK(c["v"].is_packed());
+    CHECK(c.dump("") == R"({"v": [1,2,3]})");
+    std::vector<int> ints;
+    CHECK(c["v"].copy_values(ints) && ints.size() == 3);
+
+    // JSON Patch
+    json a = {{"v", {1, 2, 3}}}, b = {{"v", {1, 5, 3, 4}}};
+    a.pack();
+    b.pack();
+    json patch = json::diff(a, b);
+    a.apply_patch(patch);
+    CHECK(a == b);
+
+    json u = {{"v", {1, 2}}};
+    u.pack();
+    u.unpack();
+    CHECK(!u["v"].is_packed());
+    CHECK(u["v"][1].try_get<int>().value_or(0) == 2);
+
+    printf("%d failures\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,135 @@
+/*
+* 以 _SJSON_PACK_NUMERIC_ARRAYS 编译（见 CMakeLists.txt），解析得到打包的 array，
+* 各种访问的结果必须与转换回普通 array 后的结果相同
+*/
+#include "sjson/sjson.hpp"
+#include "check.hpp"
+#include <string>
+
+using namespace sjson;
+
+static const char *documents[] = {
+    "[1, 2, 3]",
+    "[1.5, -2.25, 3e10]",
+    "{\"a\": [1, 2, 3], \"b\": [0.5, 1.5], \"c\": [1, 2.5], \"d\": []}",
+    "[[1, 2], [3.5, 4.5], [\"x\", 1], {\"v\": [7, 8, 9]}]",
+    "{\"series\": [[1, 2, 3], [4, 5, 6]], \"n\": 1}",
+};
+
+// 按结点逐个比较，_json 为 const json 时只经由 const 的访问
+template <typename _json>
+static bool same_nodes(_json &packed, const json &plain)
+{
+    if (packed.type() != plain.type())
+        return false;
+    if (plain.is_object())
+    {
+        for (const auto &it : plain.items())
+            if (!packed.find(it.first) || !same_nodes(packed.at(it.first), it.second))
+                return false;
+        return packed.as_object().size() == plain.as_object().size();
+    }
+    if (!plain.is_array())
+        return packed == plain;
+    const auto &arr = plain.as_array();
+    if (packed.as_array().size() != arr.size())
+        return false;
+    size_t i = 0;
+    for (const auto &e : packed.as_array())
+    {
+        if (!same_nodes(e, arr[i]) || !same_nodes(packed[i], arr[i]) ||
+            !same_nodes(packed.at(i), arr[i]))
+            return false;
+        ++i;
+    }
+    return true;
+}
+
+static size_t count_packed(const json &x)
+{
+    size_t n = x.is_packed() ? 1 : 0;
+    if (x.is_array() && !x.is_packed())
+        for (const auto &e : x.as_array())
+            n += count_packed(e);
+    else if (x.is_object())
+        for (const auto &it : x.items())
+            n += count_packed(it.second);
+    return n;
+}
+
+int main()
+{
+    for (const char *s : documents)
+    {
+        const std::string text(s);
+        json packed = json::parse(text);
+        json plain = packed;
+        plain.unpack();
+        size_t packed_cnt = count_packed(packed);
+        CHECK(packed_cnt > 0);
+        CHECK(count_packed(plain) == 0);
+
+        // const 的 operator[]、at 与遍历不改变存储
+        const json &cp = packed;
+        CHECK(same_nodes(cp, plain));
+        CHECK(count_packed(packed) == packed_cnt);
+
+        CHECK(packed == plain);
+        CHECK(packed.hash() == plain.hash());
+        CHECK(packed.dump() == plain.dump());
+        CHECK(packed.dump("") == plain.dump(""));
+
+        // 并行解析的结果同样打包
+        json parallel;
+        json::parser::parse_parallel(parallel, text.data(), text.data() + text.size(), 4);
+        CHECK(parallel == plain);
+        CHECK(parallel.is_packed() == packed.is_packed());
+
+        // 非 const 的结点访问转换回普通 array 后结果不变
+        json edited = packed;
+        CHECK(same_nodes(edited, plain));
+        CHECK(count_packed(edited) == 0);
+        CHECK(edited == plain);
+    }
+
+    // JSON Patch
+    for (const char *s : documents)
+        for (const char *t : documents)
+        {
+            json a = json::parse(std::string(s)), b = json::parse(std::string(t));
+            json ua = a, ub = b;
+            ua.unpack();
+            ub.unpack();
+            json patch = json::diff(a, b);
+            CHECK(patch == json::diff(ua, ub));
+            json patched = a;
+            patched.apply_patch(patch);
+            CHECK(patched == ub);
+            ua.apply_patch(patch);
+            CHECK(patched.dump() == ua.dump());
+        }
+
+    // json::document 复用：打包的 array 被结构不同的消息覆盖
+    json::document doc;
+    json::error_code ec;
+    for (int round = 0; round < 2; ++round)
+        for (const char *s : documents)
+        {
+            const std::string text(s);
+            CHECK(doc.parse(text, ec));
+            json plain = json::parse(text);
+            plain.unpack();
+            const json &root = doc.root();
+            CHECK(same_nodes(root, plain));
+            CHECK(root.dump() == plain.dump());
+        }
+    CHECK(doc.parse(std::string("{\"a\": [1, \"x\"], \"b\": [2.5]}"), ec));
+    CHECK(!doc.root()["a"].is_packed() && doc.root()["b"].is_packed());
+    CHECK(doc.parse(std::string("{\"a\": [1, 2], \"b\": [\"y\"]}"), ec));
+    CHECK(doc.root()["a"].is_packed() && !doc.root()["b"].is_packed());
+    CHECK(doc.root().dump("") == R"({"a": [1,2],"b": ["y"]})" ||
+          doc.root().dump("") == R"({"b": ["y"],"a": [1,2]})");
+
+    printf("%d failures\n", failures);
+    return failures != 0;
+}
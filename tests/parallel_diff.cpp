@@ -0,0 +1,97 @@
+/*
+* 差分测试：parse_parallel 与 parse 的结果必须一致，出错时错误信息也必须一致
+* 用 corpus 中的文件作为顶层 array 的元素，拼出超过并行阈值的文档，再随机修改
+*/
+#include "sjson/sjson.hpp"
+#include "corpus_util.hpp"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace sjson;
+
+static int failures = 0;
+
+static bool same_error(const json::error_code &a, const json::error_code &b)
+{
+    return a.kind == b.kind && a.offset == b.offset &&
+           a.line == b.line && a.column == b.column;
+}
+
+static void compare(const std::string &text, const char *what)
+{
+    json::error_code ec_serial, ec_parallel;
+    json serial = json::parse(text, ec_serial);
+    json parallel;
+    json::parser::parse_parallel(
+        parallel, text.data(), text.data() + text.size(), ec_parallel, 4);
+    if (bool(ec_serial) != bool(ec_parallel))
+    {
+        ++failures;
+        printf("FAIL %s: serial %s, parallel %s\n", what,
+               ec_serial.to_string().c_str(), ec_parallel.to_string().c_str());
+    }
+    else if (ec_serial ? !same_error(ec_serial, ec_parallel) : serial != parallel)
+    {
+        ++failures;
+        printf("FAIL %s: results differ (%s)\n", what, ec_serial.to_string().c_str());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> valid, invalid;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string text;
+        if (!read_file(argv[i], text))
+        {
+            printf("cannot open %s\n", argv[i]);
+            return 1;
+        }
+        (expected_kind(argv[i]) == 'n' ? invalid : valid).push_back(text);
+    }
+    if (valid.empty() || invalid.empty())
+    {
+        printf("usage: %s corpus-files...\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937 rng(20240601);
+    std::string doc = "[";
+    while (doc.size() < (3u << 19))
+    {
+        if (doc.size() > 1)
+            doc += rng() % 2 ? "," : ",\n";
+        doc += valid[rng() % valid.size()];
+    }
+    doc += "]";
+    compare(doc, "unmodified");
+
+    // 字符串中的引号、转义与括号最容易使分块阶段出错
+    const char alphabet[] = "[]{}\",:\\ \n0a-";
+    for (int round = 0; round < 60; ++round)
+    {
+        std::string text = doc;
+        size_t pos = 1 + rng() % (text.size() - 2);
+        switch (rng() % 4)
+        {
+        case 0:
+            text.insert(pos, 1, alphabet[rng() % (sizeof(alphabet) - 1)]);
+            break;
+        case 1:
+            text.erase(pos, 1);
+            break;
+        case 2:
+            text[pos] = alphabet[rng() % (sizeof(alphabet) - 1)];
+            break;
+        default:
+            text.insert(text.find(',', pos) == std::string::npos ? pos : text.find(',', pos) + 1,
+                        invalid[rng() % invalid.size()] + ",");
+            break;
+        }
+        compare(text, ("mutation " + std::to_string(round)).c_str());
+    }
+    printf("%d failures\n", failures);
+    return failures != 0;
+}